@@ -3,7 +3,8 @@
 #include <nanogui/nanogui.h>
 
 #include <engmsc/al/ALAudioContext.hpp>
-#include <engmsc/KickProducer.hpp>
+#include <engmsc/KickCache.hpp>
+#include <engmsc/CachedKickProducer.hpp>
 #include <engmsc-app/ExhaustConfigCanvas.hpp>
 #include <engmsc/WindProducer.hpp>
 
@@ -32,9 +33,10 @@ private:
     StatusDisplay statusDisplay;
     EngineConfig engineConfig;
 
-    WindProducer* windProducer;
+    VoiceHandle windVoice;
     AudioStream engineAudioStream;
     ALAudioContext audCtx;
+    KickCache kickCache;
     double elapse;
     double interval = 1.0;
     double prevInterval;
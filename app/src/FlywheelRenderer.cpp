@@ -1,4 +1,5 @@
 #include <engmsc-app/FlywheelRenderer.hpp>
+#include <engmsc/debug/Tracer.hpp>
 #include <glad/glad.h>
 #include <iostream>
 #include <cstring>
@@ -91,10 +92,14 @@ static high_resolution_clock::time_point physicsThreadElapse;
 void i_powertrainPhysicsThread()
 {
     physicsThreadElapse = high_resolution_clock::now();
+    Tracer::registerThread("Powertrain physics");
 
     while(physicsThreadRunning)
     {
-        updateEngine();
+        {
+            ENGMSC_TRACE_SCOPE("updateEngine");
+            updateEngine();
+        }
 
         physicsThreadElapse += PHYSICS_INTERVAL;
         std::this_thread::sleep_until(physicsThreadElapse);
@@ -1,11 +1,17 @@
 #include <engmsc-app/MainScreen.hpp>
 #include <engmsc-app/FlywheelRenderer.hpp>
+#include <engmsc/debug/Tracer.hpp>
 
 #include <GLFW/glfw3.h>
 
 static GLFWwindow* glfwWindow = nullptr;
 static MainScreen* screenSingleton = nullptr;
 
+//Bounds the mixing cost of dense firing trains at high RPM
+static const size_t ENGINE_MAX_POLYPHONY = 96;
+//Tails of earlier kicks under this level drop their noise transient
+static const float ENGINE_LOW_DETAIL_LEVEL = 0.01f;
+
 namespace Callbacks
 {
     static void onCursorPos(GLFWwindow*, double x, double y)
@@ -26,6 +32,11 @@ namespace Callbacks
         if(key == GLFW_KEY_Q && action == GLFW_PRESS) gearbox->setGear(gearbox->gear - 1);
         else if(key == GLFW_KEY_E && action == GLFW_PRESS) gearbox->setGear(gearbox->gear + 1);
 
+        if(key == GLFW_KEY_F12 && action == GLFW_PRESS)
+        {
+            Tracer::writeChromeTrace("engmsc-trace.json");
+        }
+
         if(key == GLFW_KEY_SPACE && action == GLFW_PRESS)
         {
             engine->isCranking = true;
@@ -54,16 +65,27 @@ namespace Callbacks
 }
 
 MainScreen::MainScreen() :
+    kickCache(engineAudioStream.getSampleRate()),
     elapse(engineAudioStream.getTime()),
     prevInterval(interval)
 {
     initialize(glfwWindow, false);
     setupGLFWcallbacks();
 
-    windProducer = new WindProducer();
+    //Steps the OS refuses (e.g. SCHED_FIFO without privileges) are skipped
+    RealtimeOptions realtimeOptions;
+    realtimeOptions.enabled = true;
+    audCtx.setRealtimeOptions(realtimeOptions);
     audCtx.initContext();
+    engineAudioStream.setMaxPolyphony(ENGINE_MAX_POLYPHONY);
+    engineAudioStream.setVoiceStealing(AudioStream::STEAL_LOWEST_PRIORITY);
+    engineAudioStream.setLowDetailLevel(ENGINE_LOW_DETAIL_LEVEL);
+    engineAudioStream.setRealtimeOptions(realtimeOptions);
+    //The stream renders on its own thread from its first block, before the context polls it
+    engineAudioStream.startRenderThread();
     audCtx.addStream(engineAudioStream);
-    engineAudioStream.playEvent(SoundEvent(windProducer));
+    //The wind bed outranks the kicks so firing trains never steal it
+    windVoice = engineAudioStream.playEvent(SoundEvent(new WindProducer(), 1.0f, 1.0f, 1));
 
     setupEngineStatusWindow(0);
     setupPowertrainInputWindow(280);
@@ -382,6 +404,7 @@ int MainScreen::setupExhaustOffsetsWindow()
 }
 
 #include <algorithm>
+#include <iir/Butterworth.h>
 
 Iir::Butterworth::LowPass<4> throttleLowpass;
 
@@ -402,6 +425,10 @@ void MainScreen::updateEngineSounds()
     double timeRemaining = elapse - now;
     double newTimeRemaining = timeRemaining * (interval / prevInterval);
     elapse -= timeRemaining - newTimeRemaining;
+
+    //Firings are collected and handed to the stream in batches rather than one by one
+    ScheduledEvent firings[AudioStream::SUBMIT_BATCH_SIZE];
+    size_t nbFirings = 0;
     while(elapse < now)
     {
         elapse += interval / nbCyl;
@@ -409,16 +436,26 @@ void MainScreen::updateEngineSounds()
         if(engine->rpm < 1.0) continue;
 
         
-        KickProducer* p = new KickProducer(throttleSoundLevel, std::max(0.0, std::min(rpm / 4000.0, 1.0)), 0.016 * (engine->revLimit / engine->rpm) / nbCyl);
+        //Firings at steady RPM reuse a pre-rendered kick instead of synthesizing a new one
+        CachedKickProducer* p = kickCache.newProducer(engineAudioStream, throttleSoundLevel, std::max(0.0, std::min(rpm / 4000.0, 1.0)), 0.016 * (engine->revLimit / engine->rpm) / nbCyl);
         //KickProducer* p = new KickProducer(6.0f, std::max(0.0, std::min(rpm / 4000.0, 1.0)));
-        engineAudioStream.playEventAt(SoundEvent(p), elapse + 0.03 + (interval / nbCyl) * 0.5f * volumes[cylIndex]);
+        if(!p) continue;
+        firings[nbFirings++] = ScheduledEvent(SoundEvent(p), elapse + 0.03 + (interval / nbCyl) * 0.5f * volumes[cylIndex]);
+        if(nbFirings == AudioStream::SUBMIT_BATCH_SIZE)
+        {
+            engineAudioStream.playEvents(firings, nbFirings);
+            nbFirings = 0;
+        }
     }
+    engineAudioStream.playEvents(firings, nbFirings);
 
-    windProducer->setWindVelocity(FlywheelRenderer::getGearbox()->kmh);
+    //Goes through the voice handle, so a wind voice that has ended just ignores it
+    engineAudioStream.setParameter(windVoice, WindProducer::WIND_VELOCITY, float(FlywheelRenderer::getGearbox()->kmh));
 }
 
 void MainScreen::destroyAudioContext()
 {
+    engineAudioStream.stop(windVoice);
     audCtx.destroyContext();
 }
 
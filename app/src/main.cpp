@@ -3,6 +3,8 @@
 
 #include <engmsc-app/MainScreen.hpp>
 #include <engmsc-app/FlywheelRenderer.hpp>
+#include <engmsc/debug/RealtimeChecker.hpp>
+#include <engmsc/debug/Tracer.hpp>
 
 
 
@@ -15,6 +17,10 @@ void initializeGLFWwindow();
 
 int main()
 {
+    //Always recording; F12 writes the last few seconds of every thread out as a Chrome trace
+    Tracer::registerThread("Main");
+    Tracer::setEnabled(true);
+
     initializeGLFWwindow();
 
     MainScreen::setGLFWwindow(glfwWindow);
@@ -24,15 +30,28 @@ int main()
 
     while(!glfwWindowShouldClose(glfwWindow))
     {
+        ENGMSC_TRACE_SCOPE("frame");
         glClearColor(0.35f, 0.5f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT);        
-        FlywheelRenderer::draw();
+        {
+            ENGMSC_TRACE_SCOPE("FlywheelRenderer::draw");
+            FlywheelRenderer::draw();
+        }
         mainScreen->refreshValues();
-        mainScreen->updateEngineSounds();
+        {
+            ENGMSC_TRACE_SCOPE("updateEngineSounds");
+            mainScreen->updateEngineSounds();
+        }
+#ifdef ENGMSC_RT_CHECKS
+        RealtimeChecker::printViolations(stderr);
+#endif
         mainScreen->draw_widgets();
 
         glfwPollEvents();
-        glfwSwapBuffers(glfwWindow);
+        {
+            ENGMSC_TRACE_SCOPE("glfwSwapBuffers");
+            glfwSwapBuffers(glfwWindow);
+        }
     }
 
     MainScreen::getScreen()->destroyAudioContext();
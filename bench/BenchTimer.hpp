@@ -0,0 +1,56 @@
+#pragma once
+
+#ifndef BENCH_TIMER_HPP
+#define BENCH_TIMER_HPP
+
+#include <inttypes.h>
+#include <algorithm>
+#include <chrono>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #else
+        #include <x86intrin.h>
+    #endif
+    #define BENCH_HAS_TSC
+#endif
+
+//Times a function by the time stamp counter where there is one, by the steady clock otherwise.
+//The best of several runs is kept, which is the least disturbed by the scheduler.
+class BenchTimer
+{
+public:
+#ifdef BENCH_HAS_TSC
+    static constexpr const char* UNIT = "cycles";
+#else
+    static constexpr const char* UNIT = "ns";
+#endif
+
+    //Best cost of one call of fn, over nbRuns runs of nbCalls calls
+    template<typename F>
+    static double measure(F fn, int nbRuns = 30, int nbCalls = 200)
+    {
+        for(int i = 0; i < nbCalls; i++) fn();
+
+        double best = 1e300;
+        for(int run = 0; run < nbRuns; run++)
+        {
+            const uint64_t start = i_now();
+            for(int i = 0; i < nbCalls; i++) fn();
+            best = std::min(best, double(i_now() - start) / nbCalls);
+        }
+        return best;
+    }
+private:
+    static uint64_t i_now()
+    {
+    #ifdef BENCH_HAS_TSC
+        return __rdtsc();
+    #else
+        return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    #endif
+    }
+};
+
+#endif
@@ -0,0 +1,128 @@
+#include <engmsc/simd/BiquadCascade.hpp>
+#include <engmsc/simd/SimdSupport.hpp>
+#include <engmsc/NoiseSource.hpp>
+
+#ifdef ENGMSC_BENCH_IIR1
+    #include <Iir.h>
+#endif
+
+#include "BenchTimer.hpp"
+
+#include <stdio.h>
+#include <vector>
+
+//Cycles per sample of each biquad kernel, per lane, for the lane counts a stream uses: one
+//lane for a bus filter, a few for channels, many for per-voice filters. With iir1 in the build
+//its Butterworth filters are timed as well, as the baseline the cascade replaced.
+
+static const double SAMPLE_RATE = 48000.0;
+static const size_t NB_FRAMES = 256;
+static const size_t LANE_COUNTS[] = {1, 2, 4, 8, 16};
+static const size_t ORDERS[] = {4, 8};
+
+template<typename T>
+class KernelBench
+{
+public:
+    typedef void (*Kernel)(const T* coefficients, T* state, T* samples, size_t nbFrames, size_t nbLanes, size_t nbSections, size_t firstLane);
+
+    KernelBench(size_t order, size_t nbLanes) :
+        m_nbLanes(nbLanes),
+        m_samples(NB_FRAMES * nbLanes)
+    {
+        BiquadCoefficients sections[ButterworthDesign::MAX_ORDER];
+        m_nbSections = ButterworthDesign::lowPass(order, SAMPLE_RATE, 1000.0, sections);
+
+        //Same layout as BiquadCascade: per section, five coefficient arrays and two state arrays of nbLanes
+        m_coefficients.resize(m_nbSections * 5 * nbLanes);
+        m_state.assign(m_nbSections * 2 * nbLanes, T(0));
+        for(size_t section = 0; section < m_nbSections; section++)
+        {
+            const double values[5] = {sections[section].b0, sections[section].b1, sections[section].b2, sections[section].a1, sections[section].a2};
+            for(size_t i = 0; i < 5; i++)
+            {
+                std::fill(m_coefficients.begin() + (section * 5 + i) * nbLanes, m_coefficients.begin() + (section * 5 + i + 1) * nbLanes, T(values[i]));
+            }
+        }
+
+        std::vector<float> noise(m_samples.size());
+        NoiseSource(1).uniform(noise.data(), noise.size());
+        std::copy(noise.begin(), noise.end(), m_samples.begin());
+    }
+
+    //Cost per sample of one lane
+    double measure(Kernel kernel)
+    {
+        const double perBlock = BenchTimer::measure([&]()
+        {
+            kernel(m_coefficients.data(), m_state.data(), m_samples.data(), NB_FRAMES, m_nbLanes, m_nbSections, 0);
+        });
+        return perBlock / double(NB_FRAMES * m_nbLanes);
+    }
+private:
+    size_t m_nbLanes;
+    size_t m_nbSections = 0;
+    std::vector<T> m_coefficients;
+    std::vector<T> m_state;
+    std::vector<T> m_samples;
+};
+
+template<typename T>
+static void benchType(const char* typeName)
+{
+    for(size_t order : ORDERS)
+    {
+        for(size_t nbLanes : LANE_COUNTS)
+        {
+            KernelBench<T> bench(order, nbLanes);
+            const double scalar = bench.measure(&BiquadKernel::processScalar);
+
+            double sse2 = 0.0;
+        #ifdef ENGMSC_SIMD_SSE2
+            sse2 = bench.measure(&BiquadKernel::processSSE2);
+        #endif
+
+            double avx2 = 0.0;
+        #ifdef ENGMSC_SIMD_AVX2
+            if(SimdSupport::hasAVX2()) avx2 = bench.measure(&BiquadKernel::processAVX2);
+        #endif
+
+            printf("%-7s %6zu %6zu %10.2f %10.2f %10.2f\n", typeName, order, nbLanes, scalar, sse2, avx2);
+        }
+    }
+}
+
+#ifdef ENGMSC_BENCH_IIR1
+template<typename Filter>
+static void benchIir(const char* name, Filter& filter)
+{
+    std::vector<float> noise(NB_FRAMES);
+    NoiseSource(1).uniform(noise.data(), NB_FRAMES);
+    std::vector<double> samples(noise.begin(), noise.end());
+
+    const double perBlock = BenchTimer::measure([&]()
+    {
+        for(double& sample : samples) sample = filter.filter(sample);
+    });
+    printf("%-24s %10.2f\n", name, perBlock / double(NB_FRAMES));
+}
+#endif
+
+int main()
+{
+    printf("Biquad kernel: %s, %s per sample per lane\n\n", BiquadKernel::getKernelName(), BenchTimer::UNIT);
+    printf("%-7s %6s %6s %10s %10s %10s\n", "type", "order", "lanes", "scalar", "sse2", "avx2");
+    benchType<float>("float");
+    benchType<double>("double");
+
+#ifdef ENGMSC_BENCH_IIR1
+    printf("\niir1, one filter, %s per sample\n", BenchTimer::UNIT);
+    Iir::Butterworth::LowPass<4> lowPass4;
+    lowPass4.setup(SAMPLE_RATE, 1000.0);
+    benchIir("LowPass<4>", lowPass4);
+    Iir::Butterworth::LowPass<8> lowPass8;
+    lowPass8.setup(SAMPLE_RATE, 1000.0);
+    benchIir("LowPass<8>", lowPass8);
+#endif
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include <engmsc/KickProducer.hpp>
+#include <engmsc/KickCache.hpp>
+#include <engmsc/CachedKickProducer.hpp>
+
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+
+//How many kick voices one core can render in real time: whole kicks are mixed into blocks as
+//the stream would, and the render time per output sample gives the voice count at each rate
+
+static const unsigned SAMPLE_RATES[] = {44100, 48000};
+static const size_t BLOCK_SIZE = 256;
+static const int NB_KICKS = 400;
+
+struct KickSettings
+{
+    const char* name;
+    float factor;
+    float factor2;
+    float duration;
+};
+
+static const KickSettings KICKS[] =
+{
+    {"idle", 0.2f, 0.3f, 0.24f},
+    {"redline", 1.0f, 0.5f, 0.12f},
+    {"long", 0.6f, 1.0f, 1.0f}
+};
+
+//Renders NB_KICKS kicks made by makeKick and returns the time per sample, in nanoseconds
+template<typename F>
+static double timeKicks(F makeKick, std::vector<float>& block)
+{
+    double best = 1e300;
+    for(int run = 0; run < 5; run++)
+    {
+        size_t nbSamples = 0;
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for(int kick = 0; kick < NB_KICKS; kick++)
+        {
+            IAudioProducer* producer = makeKick();
+            while(!producer->hasExpired())
+            {
+                nbSamples += producer->addOntoSamples(block.data(), BLOCK_SIZE);
+            }
+            delete producer;
+        }
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        best = std::min(best, seconds * 1e9 / double(nbSamples));
+    }
+    return best;
+}
+
+int main()
+{
+    std::vector<float> block(BLOCK_SIZE, 0.0f);
+
+    printf("%-8s %-6s %-14s %10s %8s\n", "kick", "rate", "path", "ns/sample", "voices");
+    for(const KickSettings& settings : KICKS)
+    {
+        for(unsigned sampleRate : SAMPLE_RATES)
+        {
+            KickCache cache(sampleRate);
+            KickCache::Table* table = cache.getTable(settings.factor, settings.factor2, settings.duration);
+
+            struct Path
+            {
+                const char* name;
+                double nsPerSample;
+            };
+            const Path paths[] =
+            {
+                {"synthesized", timeKicks([&]() -> IAudioProducer*
+                {
+                    KickProducer* kick = new KickProducer(settings.factor, settings.factor2, settings.duration);
+                    kick->setSampleRate(sampleRate);
+                    return kick;
+                }, block)},
+                {"low detail", timeKicks([&]() -> IAudioProducer*
+                {
+                    KickProducer* kick = new KickProducer(settings.factor, settings.factor2, settings.duration);
+                    kick->setSampleRate(sampleRate);
+                    kick->setLowDetail(true);
+                    return kick;
+                }, block)},
+                {"cached", timeKicks([&]() -> IAudioProducer*
+                {
+                    CachedKickProducer* kick = new CachedKickProducer(table);
+                    kick->setSampleRate(sampleRate);
+                    return kick;
+                }, block)}
+            };
+
+            for(const Path& path : paths)
+            {
+                //A voice needs sampleRate samples per second of one core
+                const double voices = 1e9 / (path.nsPerSample * sampleRate);
+                printf("%-8s %-6u %-14s %10.2f %8.0f\n", settings.name, sampleRate, path.name, path.nsPerSample, voices);
+            }
+            table->release();
+        }
+    }
+    return 0;
+}
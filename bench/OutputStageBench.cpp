@@ -0,0 +1,125 @@
+#include <engmsc/MasterBus.hpp>
+#include <engmsc/simd/OutputStage.hpp>
+#include <engmsc/simd/BiquadCascade.hpp>
+#include <engmsc/simd/SimdSupport.hpp>
+#include <engmsc/NoiseSource.hpp>
+
+#include "BenchTimer.hpp"
+
+#include <stdio.h>
+#include <vector>
+
+//Cycles per sample of the master bus output chain: each output stage kernel on its own, then
+//the whole bus against the same chain run with the scalar kernels only
+
+static const unsigned SAMPLE_RATE = 48000;
+static const size_t BLOCK_SIZES[] = {64, 256, 1024};
+
+//Mix levels go past full scale now and then, so the clipper sees both regions
+static const float MIX_LEVEL = 1.5f;
+
+//The bus as it runs without SIMD: a one-lane cascade per filter, then the scalar output stage
+class ScalarBus
+{
+public:
+    ScalarBus()
+    {
+        BiquadCoefficients sections[ButterworthDesign::MAX_ORDER];
+        m_nbHighPassSections = ButterworthDesign::highPass(4, SAMPLE_RATE, 20.0, sections);
+        i_load(m_highPass, sections, m_nbHighPassSections);
+        m_nbLowPassSections = ButterworthDesign::lowPass(4, SAMPLE_RATE, 500.0, sections);
+        i_load(m_lowPass, sections, m_nbLowPassSections);
+    }
+
+    void process(float* mix, int16_t* output, size_t nbSamples)
+    {
+        std::vector<double>& highPassed = m_highPassed;
+        std::vector<double>& lowPassed = m_lowPassed;
+        highPassed.assign(mix, mix + nbSamples);
+        BiquadKernel::processScalar(m_highPass.coefficients, m_highPass.state, highPassed.data(), nbSamples, 1, m_nbHighPassSections, 0);
+        lowPassed.assign(highPassed.begin(), highPassed.end());
+        BiquadKernel::processScalar(m_lowPass.coefficients, m_lowPass.state, lowPassed.data(), nbSamples, 1, m_nbLowPassSections, 0);
+
+        for(size_t i = 0; i < nbSamples; i++)
+        {
+            mix[i] = float(highPassed[i] * 0.5 + lowPassed[i]);
+        }
+        OutputStage::processScalar(mix, output, nbSamples);
+    }
+private:
+    struct Filter
+    {
+        double coefficients[ButterworthDesign::MAX_ORDER * 5] = {};
+        double state[ButterworthDesign::MAX_ORDER * 2] = {};
+    };
+
+    Filter m_highPass;
+    Filter m_lowPass;
+    size_t m_nbHighPassSections;
+    size_t m_nbLowPassSections;
+    std::vector<double> m_highPassed;
+    std::vector<double> m_lowPassed;
+
+    static void i_load(Filter& filter, const BiquadCoefficients* sections, size_t nbSections)
+    {
+        for(size_t section = 0; section < nbSections; section++)
+        {
+            double* coefficients = filter.coefficients + section * 5;
+            coefficients[0] = sections[section].b0;
+            coefficients[1] = sections[section].b1;
+            coefficients[2] = sections[section].b2;
+            coefficients[3] = sections[section].a1;
+            coefficients[4] = sections[section].a2;
+        }
+    }
+};
+
+int main()
+{
+    printf("Output stage kernel: %s, biquad kernel: %s, %s per sample\n\n", OutputStage::getKernelName(), BiquadKernel::getKernelName(), BenchTimer::UNIT);
+    printf("%-8s %10s %10s %10s %12s %12s\n", "block", "scalar", "sse2", "avx2", "bus scalar", "bus");
+
+    NoiseSource noise;
+    for(size_t blockSize : BLOCK_SIZES)
+    {
+        std::vector<float> input(blockSize);
+        std::vector<float> mix(blockSize);
+        std::vector<int16_t> output(blockSize);
+        noise.uniform(input.data(), blockSize);
+        for(float& sample : input) sample *= MIX_LEVEL;
+
+        const double perSample = 1.0 / double(blockSize);
+        const double scalar = BenchTimer::measure([&]() { OutputStage::processScalar(input.data(), output.data(), blockSize); }) * perSample;
+
+        double sse2 = 0.0;
+    #ifdef ENGMSC_SIMD_SSE2
+        sse2 = BenchTimer::measure([&]() { OutputStage::processSSE2(input.data(), output.data(), blockSize); }) * perSample;
+    #endif
+
+        double avx2 = 0.0;
+    #ifdef ENGMSC_SIMD_AVX2
+        if(SimdSupport::hasAVX2())
+        {
+            avx2 = BenchTimer::measure([&]() { OutputStage::processAVX2(input.data(), output.data(), blockSize); }) * perSample;
+        }
+    #endif
+
+        //The bus filters the mix in place, so each call starts from a fresh copy
+        ScalarBus scalarBus;
+        const double busScalar = BenchTimer::measure([&]()
+        {
+            mix = input;
+            scalarBus.process(mix.data(), output.data(), blockSize);
+        }) * perSample;
+
+        MasterBus bus(SAMPLE_RATE);
+        const double busSimd = BenchTimer::measure([&]()
+        {
+            mix = input;
+            bus.process(mix.data(), output.data(), blockSize);
+        }) * perSample;
+
+        printf("%-8zu %10.2f %10.2f %10.2f %12.2f %12.2f\n", blockSize, scalar, sse2, avx2, busScalar, busSimd);
+    }
+    return 0;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#ifndef AUDIO_STATS_HPP
+#define AUDIO_STATS_HPP
+
+#include <stddef.h>
+#include <inttypes.h>
+#include <atomic>
+
+//Distribution of durations written by one thread and readable from any other without locks.
+//Durations go into a log histogram with 8 buckets per octave, so percentiles are accurate to
+//about 9%; min, max and average are exact.
+class TimingStats
+{
+public:
+    TimingStats();
+
+    void record(int64_t nanoseconds);
+    void reset();
+
+    size_t getCount() const;
+    double getMin() const;
+    double getAverage() const;
+    double getMax() const;
+    double getPercentile(double percentile) const;
+
+    TimingStats(const TimingStats& copy) = delete;
+    TimingStats& operator=(const TimingStats& copy) = delete;
+private:
+    static constexpr int SUB_BUCKET_BITS = 3;
+    static constexpr size_t NB_BUCKETS = 48 << SUB_BUCKET_BITS;
+
+    std::atomic<uint64_t> m_count{0};
+    std::atomic<uint64_t> m_total{0};
+    std::atomic<uint64_t> m_min{UINT64_MAX};
+    std::atomic<uint64_t> m_max{0};
+    std::atomic<uint32_t> m_buckets[NB_BUCKETS];
+
+    static size_t i_bucketFor(uint64_t nanoseconds);
+    static uint64_t i_bucketUpperBound(size_t bucket);
+};
+
+//Durations are in seconds, loads in percent of the block duration
+struct AudioStreamStats
+{
+    size_t nbBlocks = 0;
+    double renderTimeMin = 0.0;
+    double renderTimeAvg = 0.0;
+    double renderTimeP99 = 0.0;
+    double renderTimeMax = 0.0;
+    double dspLoad = 0.0;
+    double dspLoadP99 = 0.0;
+    double dspLoadPeak = 0.0;
+
+    size_t activeVoices = 0;
+    size_t pendingVoices = 0;
+    size_t lateEvents = 0;
+    size_t droppedEvents = 0;
+    size_t stolenVoices = 0;
+    size_t refusedVoices = 0;
+    size_t culledVoices = 0;
+    size_t resyncs = 0;
+    size_t underruns = 0;
+};
+
+struct AudioContextStats
+{
+    size_t nbStreams = 0;
+    size_t underruns = 0;
+    size_t nbPolls = 0;
+    double pollTimeAvg = 0.0;
+    double pollTimeP99 = 0.0;
+    double pollTimeMax = 0.0;
+};
+
+#endif
@@ -5,31 +5,121 @@
 
 #include <inttypes.h>
 #include <engmsc/SoundEvent.hpp>
+#include <engmsc/VoiceHandle.hpp>
+#include <engmsc/LockFreeQueue.hpp>
+#include <engmsc/MasterBus.hpp>
+#include <engmsc/MixThreadPool.hpp>
+#include <engmsc/VoicePool.hpp>
+#include <engmsc/RealtimeMode.hpp>
+#include <engmsc/AudioStats.hpp>
 
-#include <forward_list>
-#include <queue>
+#include <vector>
 
 #include <thread>
 #include <mutex>
 #include <condition_variable>
-
-#define SAMPLE_RATE 44100
-#define SAMPLES_PER_BUFFER 1024
-#define BUFFER_POOL_SIZE 4
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <typeindex>
+#include <unordered_map>
 
 class AudioStream
 {
 public:
-    AudioStream();
+    //Which active voice gives way when a new one starts at the polyphony limit
+    enum VoiceStealing
+    {
+        STEAL_OLDEST,
+        STEAL_QUIETEST,
+        STEAL_LOWEST_PRIORITY
+    };
+
+    AudioStream(unsigned sampleRate = 44100, size_t samplesPerBuffer = 1024, size_t bufferPoolSize = 4);
+
+    VoiceHandle playEvent(const SoundEvent& event);
+    VoiceHandle playEventAt(const SoundEvent& event, double seconds);
+    VoiceHandle playEventIn(const SoundEvent& event, double seconds);
+    VoiceHandle playEventAtSample(const SoundEvent& event, int64_t sample);
+
+    //Queues a batch of events with one synchronization per SUBMIT_BATCH_SIZE events and no
+    //allocation. Handles are written to voices when given (invalid for events that were not
+    //queued). Returns how many events were queued.
+    size_t playEvents(const ScheduledEvent* events, size_t nbEvents, VoiceHandle* voices = nullptr);
 
-    void playEvent(const SoundEvent& event);
-    void playEventAt(const SoundEvent& event, double seconds);
-    void playEventIn(const SoundEvent& event, double seconds);
+    //Voice controls are queued like events and take effect at the next block. They return
+    //false if the command queue is full; stale handles are ignored by the render side.
+    bool stop(VoiceHandle voice);
+    bool setVolume(VoiceHandle voice, float volume);
+    bool setPitch(VoiceHandle voice, float pitch);
+    //Hands value to the voice's producer through IAudioProducer::setParameter on the render
+    //thread, so the producer is never touched after the voice could have ended
+    bool setParameter(VoiceHandle voice, int parameter, float value);
+    bool isPlaying(VoiceHandle voice) const;
+
+    //Producers built here live in a per-type pool owned by the stream and are recycled
+    //after they expire. Returns nullptr when the pool for T is exhausted.
+    template<typename T, typename... Args> T* newProducer(Args&&... args);
+    template<typename T> void reserveVoicePool(size_t capacity);
     const int16_t* getNextBuffer();
+    const int16_t* tryGetNextBuffer();
     double getTime();
+    int64_t getSampleTime();
+    int64_t timeToSample(double seconds) const;
+    double sampleToTime(int64_t sample) const;
     size_t getNbSounds() const;
+    unsigned getSampleRate() const;
+    size_t getSamplesPerBuffer() const;
+    size_t getBufferPoolSize() const;
+    double getBufferDuration() const;
+    MasterBus& getMasterBus();
+    size_t getNbLateEvents() const;
+    size_t getNbDroppedEvents() const;
+    int64_t getMaxLateness() const;
     void resartStream();
 
+    //Without a render thread the consumer renders inline in tryGetNextBuffer(). Starting and
+    //stopping the thread hand rendering over only once the consumer is out of that call, so
+    //the two never render at once; both are safe while the stream is attached to a context.
+    void startRenderThread();
+    void stopRenderThread();
+    bool isRenderThreadRunning() const;
+    void setMixThreads(size_t nbThreads);
+    size_t getMixThreads() const;
+
+    //Applies to the render thread (pinned to options.cpu) and the mix workers (the CPUs after
+    //it), restarting them if they run. Locking covers the block pool and the voice tables.
+    //Without a render thread the context's worker renders, so its own options apply.
+    void setRealtimeOptions(const RealtimeOptions& options);
+    RealtimeReport getRealtimeReport();
+
+    //0 leaves polyphony unbounded. Stolen and stopped voices fade out over a few milliseconds.
+    //Under STEAL_LOWEST_PRIORITY a new voice that ranks below every active one is not started
+    //and is counted as refused rather than stolen.
+    void setMaxPolyphony(size_t maxVoices);
+    size_t getMaxPolyphony() const;
+    void setVoiceStealing(VoiceStealing policy);
+    VoiceStealing getVoiceStealing() const;
+    size_t getNbStolenVoices() const;
+    size_t getNbRefusedVoices() const;
+
+    //Voices whose remaining peak (volume times the producer's estimate) falls under the cull
+    //level are retired early; by default that is half an output LSB. Voices under the low
+    //detail level switch to their producer's cheaper path; 0 disables it.
+    void setCullLevel(float level);
+    float getCullLevel() const;
+    void setLowDetailLevel(float level);
+    float getLowDetailLevel() const;
+    size_t getNbCulledVoices() const;
+
+    //Safe to call from any thread at any rate; the render side only does relaxed stores.
+    //resetStats clears the render time distribution, counters keep running.
+    AudioStreamStats getStats() const;
+    void resetStats();
+
+    static constexpr size_t DEFAULT_VOICE_POOL_CAPACITY = 1024;
+    static constexpr size_t SUBMIT_BATCH_SIZE = 32;
+
     AudioStream(const AudioStream& copy) = delete;
     AudioStream operator=(const AudioStream& copy) = delete;
 
@@ -38,33 +128,206 @@ private:
     struct Buffer
     {
         int id = 0;
-        uint16_t* data = nullptr;
+        int16_t* data = nullptr;
     };
     struct TimedSoundEvent
     {
-        TimedSoundEvent(const SoundEvent& event, double time);
+        TimedSoundEvent();
+        TimedSoundEvent(const SoundEvent& event, int64_t sample);
         SoundEvent event;
-        double timeToPlay = 0.0;
-        bool hasStarted = false;
+        int64_t sampleToPlay = 0;
+        uint32_t voice = VoiceHandle::INVALID_INDEX;
+    };
+    struct Command
+    {
+        enum Type
+        {
+            PLAY,
+            STOP,
+            SET_VOLUME,
+            SET_PITCH,
+            SET_PARAMETER
+        };
+        Type type = PLAY;
+        VoiceHandle voice;
+        int parameter = 0;
+        float value = 0.0f;
+        TimedSoundEvent sound;
+    };
+    struct VoiceControl
+    {
+        float volume = 1.0f;
+        float pitch = 1.0f;
+        bool stopped = false;
+        IAudioProducer* producer = nullptr;
+    };
+    struct LaterSoundEvent
+    {
+        bool operator()(const TimedSoundEvent& a, const TimedSoundEvent& b) const;
+    };
+
+    const unsigned m_sampleRate;
+    const size_t m_samplesPerBuffer;
+    const size_t m_bufferPoolSize;
+    const double m_bufferDuration;
+    const double m_compensationDelay;
+    const int64_t m_maxEventLateness;
+
+    std::atomic<size_t> m_nbSounds{0};
+    std::atomic<size_t> m_nbLateEvents{0};
+    std::atomic<size_t> m_nbDroppedEvents{0};
+    std::atomic<int64_t> m_maxLateness{0};
+    std::atomic<size_t> m_nbStolenVoices{0};
+    std::atomic<size_t> m_nbRefusedVoices{0};
+    std::atomic<size_t> m_nbCulledVoices{0};
+    std::atomic<size_t> m_nbResyncs{0};
+    std::atomic<size_t> m_nbUnderruns{0};
+    std::atomic<size_t> m_nbActiveVoices{0};
+    std::atomic<size_t> m_nbPendingVoices{0};
+    TimingStats m_renderTimes;
+
+    std::atomic<float> m_cullLevel;
+    std::atomic<float> m_lowDetailLevel{0.0f};
+
+    std::atomic<size_t> m_maxPolyphony{0};
+    std::atomic<VoiceStealing> m_voiceStealing{STEAL_OLDEST};
+    const size_t m_fadeSamples;
+
+    MPSCQueue<Command> m_commandQueue;
+    SPSCQueue<IAudioProducer*> m_retiredProducers;
+    std::vector<TimedSoundEvent> m_pendingSounds;
+    std::vector<TimedSoundEvent> m_activeSounds;
+    std::vector<TimedSoundEvent> m_fadingSounds;
+
+    //Generations are published by the render side when a voice ends; controls are render-side only
+    LockFreeIndexStack m_freeVoices;
+    std::unique_ptr<std::atomic<uint32_t>[]> m_voiceGenerations;
+    std::vector<VoiceControl> m_voiceControls;
+
+    //Rendered blocks flow renderer -> consumer through m_readyBuffers and come back through
+    //m_freeBuffers, so neither side ever takes a lock to hand a block over
+    SPSCQueue<Buffer*> m_readyBuffers;
+    SPSCQueue<Buffer*> m_freeBuffers;
+    Buffer* m_heldBuffer = nullptr;
+
+    //Who renders blocks. Only control calls change it, under m_renderControlMutex, and a change
+    //waits for the consumer to leave tryGetNextBuffer() so it never overlaps the old renderer.
+    enum RenderMode
+    {
+        RENDER_INLINE,
+        RENDER_THREAD,
+        RENDER_PAUSED
     };
+    std::atomic<int> m_renderMode{RENDER_INLINE};
+    std::atomic<bool> m_consumerActive{false};
+    std::mutex m_renderControlMutex;
+
+    std::thread* m_renderThread = nullptr;
+    std::atomic<bool> m_renderThreadRunning{false};
+    std::mutex m_renderMutex;
+    std::condition_variable m_renderCV;
 
-    size_t m_nbSounds = 0;
+    RealtimeOptions m_realtimeOptions;
+    RealtimeReport m_renderRealtimeReport;
+    std::mutex m_realtimeReportMutex;
+    bool m_memoryLocked = false;
 
-    std::mutex m_soundsMutex;
-    std::forward_list<TimedSoundEvent> m_activeSounds;
+    std::thread* m_housekeepingThread = nullptr;
+    bool m_housekeepingRunning = true;
+    std::mutex m_housekeepingMutex;
+    std::condition_variable m_housekeepingCV;
 
-    std::queue<Buffer*> m_outputBufferQueue;
-    std::queue<Buffer*> m_inputBufferQueue;
+    int16_t* const m_bufferPoolData;
+    std::vector<Buffer> m_bufferPool;
 
-    uint16_t* const m_bufferPoolData;
-    Buffer m_bufferPool[BUFFER_POOL_SIZE];
+    std::chrono::steady_clock::time_point m_timeStreamStarted;
 
-    size_t m_timeStreamStarted;
+    //Stream time of sample 0, slewed every buffer to follow the wall clock
+    std::atomic<double> m_timelineEpoch;
 
+    //Pools are owned by the map. Each producer type also gets a process-wide slot on first use,
+    //and the stream caches its pool there, so later lookups are one atomic load without the lock.
+    static constexpr size_t MAX_VOICE_POOL_TYPES = 32;
+    std::mutex m_voicePoolMutex;
+    std::unordered_map<std::type_index, std::unique_ptr<IVoicePool>> m_voicePools;
+    std::atomic<IVoicePool*> m_voicePoolSlots[MAX_VOICE_POOL_TYPES] = {};
+    static size_t i_nextVoicePoolSlot();
+    template<typename T> static size_t i_voicePoolSlot();
+    template<typename T> VoicePool<T>& i_getVoicePool(size_t capacity);
+
+    MasterBus m_masterBus;
+    MixThreadPool* m_mixThreadPool = nullptr;
     float* m_workBuffer;
-    double m_bufferTime;
-    void i_fillNextBuffers();
+    float* m_fadeBuffer;
+    int64_t m_bufferSample = 0;
+    VoiceHandle i_submitEvent(const SoundEvent& event, int64_t sample);
+    VoiceHandle i_makePlayCommand(const SoundEvent& event, int64_t sample, Command& command);
+    void i_cancelPlayCommand(const Command& command);
+    bool i_submitControl(Command::Type type, VoiceHandle voice, float value, int parameter = 0);
+    void i_drainCommandQueue();
+    void i_applyCommand(const Command& command);
+    void i_endVoice(TimedSoundEvent& sound);
+    void i_startPendingSounds();
+    void i_removeExpiredSounds();
+    bool i_stealVoiceFor(const TimedSoundEvent& sound);
+    void i_fadeOutVoice(size_t activeIndex);
+    void i_mixFadingSounds(size_t nbSamples);
+    void i_retireProducer(IAudioProducer* producer);
+    void i_disposeRetiredProducers();
+    void i_housekeepingThread();
+    void i_mixActiveSounds(size_t nbSamples);
+    static void i_mixSoundsJob(void* stream, size_t jobIndex, float* scratch, size_t nbSamples);
+    void i_advanceTimeline();
+
+    void i_renderBlock(int16_t* output);
+    bool i_renderNextBuffer();
+    void i_releaseHeldBuffer();
+    void i_renderThread();
+    void i_setRenderMode(RenderMode mode);
+    RenderMode i_pauseRendering();
+    void i_resumeRendering(RenderMode mode);
+    void i_setMixThreads(size_t nbThreads);
+    bool i_lockMemory(bool lock);
     friend class MainScreen;
+    friend class IAudioContext;
 };
 
+template<typename T, typename... Args>
+T* AudioStream::newProducer(Args&&... args)
+{
+    return i_getVoicePool<T>(DEFAULT_VOICE_POOL_CAPACITY).create(std::forward<Args>(args)...);
+}
+
+template<typename T>
+void AudioStream::reserveVoicePool(size_t capacity)
+{
+    i_getVoicePool<T>(capacity);
+}
+
+template<typename T>
+size_t AudioStream::i_voicePoolSlot()
+{
+    static const size_t slot = i_nextVoicePoolSlot();
+    return slot;
+}
+
+template<typename T>
+VoicePool<T>& AudioStream::i_getVoicePool(size_t capacity)
+{
+    const size_t slot = i_voicePoolSlot<T>();
+    if(slot < MAX_VOICE_POOL_TYPES)
+    {
+        IVoicePool* pool = m_voicePoolSlots[slot].load(std::memory_order_acquire);
+        if(pool) return static_cast<VoicePool<T>&>(*pool);
+    }
+
+    //First use of T on this stream, or more types than slots. Only producer-side threads take
+    //this lock; the render thread reaches pools through the producers.
+    std::unique_lock<std::mutex> lock(m_voicePoolMutex);
+    std::unique_ptr<IVoicePool>& pool = m_voicePools[std::type_index(typeid(T))];
+    if(!pool) pool.reset(new VoicePool<T>(capacity));
+    if(slot < MAX_VOICE_POOL_TYPES) m_voicePoolSlots[slot].store(pool.get(), std::memory_order_release);
+    return static_cast<VoicePool<T>&>(*pool);
+}
+
 #endif
\ No newline at end of file
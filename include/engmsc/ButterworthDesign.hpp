@@ -0,0 +1,39 @@
+#pragma once
+
+#ifndef BUTTERWORTH_DESIGN_HPP
+#define BUTTERWORTH_DESIGN_HPP
+
+#include <stddef.h>
+
+//One second-order section, normalized so that a0 = 1:
+//y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2]
+struct BiquadCoefficients
+{
+    double b0 = 1.0;
+    double b1 = 0.0;
+    double b2 = 0.0;
+    double a1 = 0.0;
+    double a2 = 0.0;
+};
+
+//Digital Butterworth filters by bilinear transform with prewarped edges, split into biquads.
+//Orders and band edges follow iir1: lowPass(4, ...) is Iir::Butterworth::LowPass<4>, and
+//bandPass of order N has 2N poles with its -3 dB edges at center -+ width / 2. Pass bands
+//are normalized to unity gain (DC, Nyquist or the geometric center). Each designer writes
+//its sections and returns how many it wrote.
+class ButterworthDesign
+{
+public:
+    static constexpr size_t MAX_ORDER = 16;
+
+    static size_t lowPass(size_t order, double sampleRate, double cutoff, BiquadCoefficients* sections);
+    static size_t highPass(size_t order, double sampleRate, double cutoff, BiquadCoefficients* sections);
+    static size_t bandPass(size_t order, double sampleRate, double centerFrequency, double widthFrequency, BiquadCoefficients* sections);
+
+    static size_t getNbSections(size_t order);
+    static size_t getNbBandPassSections(size_t order);
+private:
+    static size_t i_lowOrHighPass(size_t order, double sampleRate, double cutoff, bool highPass, BiquadCoefficients* sections);
+};
+
+#endif
@@ -0,0 +1,31 @@
+#pragma once
+
+#ifndef CACHED_KICK_PRODUCER_HPP
+#define CACHED_KICK_PRODUCER_HPP
+
+#include <engmsc/IAudioProducer.hpp>
+#include <engmsc/KickCache.hpp>
+
+//Plays a kick pre-rendered by KickCache. The table is played at the rate it was rendered at,
+//so pitch and low detail are ignored; the copy is already cheaper than any reduced synthesis.
+class CachedKickProducer : public IAudioProducer
+{
+public:
+    CachedKickProducer(KickCache::Table* table);
+
+    virtual size_t produceSamples(float* buffer, size_t bufferSize) override;
+    virtual size_t addOntoSamples(float* buffer, size_t bufferSize, float gain = 1.0f) override;
+    virtual double getDuration() const override;
+    virtual bool hasExpired() const override;
+    virtual float getPeakLevel() const override;
+
+    CachedKickProducer(const CachedKickProducer& copy) = delete;
+    void operator=(const CachedKickProducer& copy) = delete;
+
+    virtual ~CachedKickProducer();
+private:
+    KickCache::Table* m_table;
+    size_t m_samplePos = 0;
+};
+
+#endif
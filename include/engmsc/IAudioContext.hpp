@@ -17,6 +17,9 @@ public:
 
     IAudioContext(const IAudioContext& copy) = delete;
     void operator=(const IAudioContext& copy) = delete;
+protected:
+    //Lets contexts count underruns into the stream's statistics
+    static void reportUnderrun(AudioStream& audioStream);
 };
 
 #endif
\ No newline at end of file
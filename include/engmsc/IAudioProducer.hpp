@@ -6,6 +6,8 @@
 #include <inttypes.h>
 #include <stddef.h>
 
+class IVoicePool;
+
 class IAudioProducer
 {
 public:
@@ -16,7 +18,32 @@ public:
     virtual double getDuration() const = 0;
     virtual bool hasExpired() const = 0;
 
+    //Producers that can transpose override this; the default ignores pitch
+    virtual void setPitch(float pitch);
+
+    //Upper bound on the magnitude of the remaining output before gain; 1 when unknown
+    virtual float getPeakLevel() const;
+
+    //Producers with a cheaper synthesis path use it while low detail is set; the default ignores it
+    virtual void setLowDetail(bool lowDetail);
+
+    //Producer-specific controls, called on the render thread by AudioStream::setParameter();
+    //the default ignores them
+    virtual void setParameter(int parameter, float value);
+
+    void setSampleRate(unsigned sampleRate);
+    unsigned getSampleRate() const;
+
+    //Pooled producers go back to their pool instead of being deleted
+    static void dispose(IAudioProducer* producer);
+    IVoicePool* getVoicePool() const;
+
     virtual ~IAudioProducer();
+protected:
+    unsigned m_sampleRate = 44100;
+private:
+    template<typename T> friend class VoicePool;
+    IVoicePool* m_voicePool = nullptr;
 };
 
 #endif
\ No newline at end of file
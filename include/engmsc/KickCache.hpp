@@ -0,0 +1,125 @@
+#pragma once
+
+#ifndef KICK_CACHE_HPP
+#define KICK_CACHE_HPP
+
+#include <stddef.h>
+#include <inttypes.h>
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+class AudioStream;
+class CachedKickProducer;
+
+struct KickCacheStats
+{
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+    size_t nbTables = 0;
+    size_t memoryUsage = 0;
+    size_t memoryLimit = 0;
+};
+
+//Pre-rendered KickProducer transients, keyed by (factor, factor2, duration) rounded to a grid.
+//Firings at steady RPM land on the same few keys, so a kick is synthesized once and then played
+//as a gain-scaled copy by CachedKickProducer. Tables are kept in least recently used order and
+//evicted once their total size passes the memory limit; a table still playing stays alive
+//until its last voice is disposed of.
+//
+//Lookups lock a mutex and may render, so they belong on producer-side threads, like
+//AudioStream::newProducer. Playback never touches the cache.
+class KickCache
+{
+public:
+    static constexpr size_t DEFAULT_MEMORY_LIMIT = 8 * 1024 * 1024;
+    static constexpr float DEFAULT_FACTOR_STEP = 1.0f / 64.0f;
+    static constexpr float DEFAULT_FACTOR2_STEP = 1.0f / 64.0f;
+    static constexpr float DEFAULT_DURATION_STEP = 0.0005f;
+
+    class Table
+    {
+    public:
+        const float* getSamples() const;
+        size_t getNbSamples() const;
+
+        //Largest magnitude from the given sample to the end of the table
+        float getPeakFrom(size_t sample) const;
+
+        void retain();
+        void release();
+    private:
+        friend class KickCache;
+        static const size_t PEAK_BLOCK_SIZE = 256;
+
+        Table(size_t nbSamples);
+        ~Table();
+        size_t i_memoryUsage() const;
+
+        float* m_samples;
+        size_t m_nbSamples;
+        float* m_peaks;
+        std::atomic<int> m_refs{1};
+    };
+
+    KickCache(unsigned sampleRate = 44100, size_t memoryLimit = DEFAULT_MEMORY_LIMIT);
+
+    //Parameters as for KickProducer. The table comes back retained; the caller releases it.
+    Table* getTable(float factor, float factor2, float duration);
+
+    //Returns a producer from the stream's voice pool playing the cached kick, or nullptr when
+    //the pool is exhausted or the stream's sample rate differs from the cache's
+    CachedKickProducer* newProducer(AudioStream& stream, float factor, float factor2, float duration);
+
+    //Smaller steps sound closer to per-firing synthesis but hit less often. Clears the cache.
+    void setQuantization(float factorStep, float factor2Step, float durationStep);
+    void setMemoryLimit(size_t bytes);
+    size_t getMemoryLimit() const;
+    unsigned getSampleRate() const;
+    void clear();
+
+    KickCacheStats getStats() const;
+    void resetStats();
+
+    KickCache(const KickCache& copy) = delete;
+    void operator=(const KickCache& copy) = delete;
+
+    ~KickCache();
+private:
+    struct Key
+    {
+        int32_t factor;
+        int32_t factor2;
+        int32_t duration;
+
+        bool operator==(const Key& key) const;
+    };
+    struct KeyHash
+    {
+        size_t operator()(const Key& key) const;
+    };
+    typedef std::list<std::pair<Key, Table*>> LruList;
+
+    unsigned m_sampleRate;
+    size_t m_memoryLimit;
+    size_t m_memoryUsage = 0;
+    float m_factorStep = DEFAULT_FACTOR_STEP;
+    float m_factor2Step = DEFAULT_FACTOR2_STEP;
+    float m_durationStep = DEFAULT_DURATION_STEP;
+
+    mutable std::mutex m_mutex;
+    LruList m_lru;
+    std::unordered_map<Key, LruList::iterator, KeyHash> m_tables;
+
+    size_t m_nbHits = 0;
+    size_t m_nbMisses = 0;
+    size_t m_nbEvictions = 0;
+
+    Table* i_render(const Key& key) const;
+    //Drops least recently used tables until the usage is within the limit; returns how many
+    size_t i_evict(size_t limit);
+};
+
+#endif
@@ -4,6 +4,7 @@
 #define KICK_PRODUCER_HPP
 
 #include <engmsc/IAudioProducer.hpp>
+#include <engmsc/NoiseSource.hpp>
 
 class KickProducer : public IAudioProducer
 {
@@ -14,13 +15,22 @@ public:
     virtual size_t addOntoSamples(float* buffer, size_t bufferSize, float gain = 1.0f) override;
     virtual double getDuration() const override;
     virtual bool hasExpired() const override;
+    virtual void setPitch(float pitch) override;
+    virtual float getPeakLevel() const override;
+    virtual void setLowDetail(bool lowDetail) override;
+
+    void setNoiseSeed(uint32_t seed);
 private:
     float m_factor;
     float m_factor2;
+    float m_pitch = 1.0f;
     double m_duration;
     bool m_hasExpired = false;
+    bool m_lowDetail = false;
     size_t m_samplePos = 0;
-    inline float genSample() const;
+    double m_phase = 0.0;
+    NoiseSource m_noise;
+    void i_renderBlock(float* output, const float* noise, size_t nbSamples, float gain);
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,271 @@
+#pragma once
+
+#ifndef LOCK_FREE_QUEUE_HPP
+#define LOCK_FREE_QUEUE_HPP
+
+#include <stddef.h>
+#include <inttypes.h>
+#include <atomic>
+#include <memory>
+
+#define ENGMSC_CACHE_LINE 64
+
+//Rounds up to the next power of two so positions can be masked instead of divided
+inline size_t lockFreeQueueCapacity(size_t capacity)
+{
+    size_t powerOfTwo = 2;
+    while(powerOfTwo < capacity) powerOfTwo <<= 1;
+    return powerOfTwo;
+}
+
+//Bounded wait-free queue for exactly one producer thread and one consumer thread
+template<typename T>
+class SPSCQueue
+{
+public:
+    SPSCQueue(size_t capacity) :
+        m_capacity(lockFreeQueueCapacity(capacity)),
+        m_mask(m_capacity - 1),
+        m_slots(new T[m_capacity]) {}
+
+    bool tryPush(const T& value)
+    {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if(tail - m_cachedHead == m_capacity)
+        {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if(tail - m_cachedHead == m_capacity) return false;
+        }
+
+        m_slots[tail & m_mask] = value;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPop(T& value)
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if(head == m_cachedTail)
+        {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if(head == m_cachedTail) return false;
+        }
+
+        value = m_slots[head & m_mask];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t size() const
+    {
+        return m_tail.load(std::memory_order_acquire) - m_head.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const
+    {
+        return m_capacity;
+    }
+
+    SPSCQueue(const SPSCQueue& copy) = delete;
+    SPSCQueue& operator=(const SPSCQueue& copy) = delete;
+private:
+    const size_t m_capacity;
+    const size_t m_mask;
+    std::unique_ptr<T[]> m_slots;
+
+    alignas(ENGMSC_CACHE_LINE) std::atomic<size_t> m_head{0};
+    size_t m_cachedTail = 0;
+
+    alignas(ENGMSC_CACHE_LINE) std::atomic<size_t> m_tail{0};
+    size_t m_cachedHead = 0;
+};
+
+//Bounded lock-free queue for any number of producer threads and one consumer thread.
+//Each slot carries a sequence number so producers only contend on the tail counter.
+template<typename T>
+class MPSCQueue
+{
+public:
+    MPSCQueue(size_t capacity) :
+        m_capacity(lockFreeQueueCapacity(capacity)),
+        m_mask(m_capacity - 1),
+        m_slots(new Slot[m_capacity])
+    {
+        for(size_t i = 0; i < m_capacity; i++)
+        {
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool tryPush(const T& value)
+    {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        for(;;)
+        {
+            Slot& slot = m_slots[tail & m_mask];
+            const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+            const ptrdiff_t diff = ptrdiff_t(sequence) - ptrdiff_t(tail);
+
+            if(diff == 0)
+            {
+                if(m_tail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed))
+                {
+                    slot.value = value;
+                    slot.sequence.store(tail + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if(diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                tail = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    //Claims count consecutive slots with a single CAS on the tail. Either the whole batch is
+    //queued, in order and without interleaving, or nothing is and false is returned.
+    bool tryPushBatch(const T* values, size_t count)
+    {
+        if(count == 0) return true;
+        if(count > m_capacity) return false;
+
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        for(;;)
+        {
+            //The consumer frees slots in order, so if the last one is free the ones before it are too
+            const size_t last = tail + count - 1;
+            const ptrdiff_t firstDiff = ptrdiff_t(m_slots[tail & m_mask].sequence.load(std::memory_order_acquire)) - ptrdiff_t(tail);
+            const ptrdiff_t lastDiff = ptrdiff_t(m_slots[last & m_mask].sequence.load(std::memory_order_acquire)) - ptrdiff_t(last);
+
+            if(firstDiff == 0 && lastDiff == 0)
+            {
+                if(m_tail.compare_exchange_weak(tail, tail + count, std::memory_order_relaxed))
+                {
+                    for(size_t i = 0; i < count; i++)
+                    {
+                        Slot& slot = m_slots[(tail + i) & m_mask];
+                        slot.value = values[i];
+                        slot.sequence.store(tail + i + 1, std::memory_order_release);
+                    }
+                    return true;
+                }
+            }
+            else if(firstDiff < 0 || (firstDiff == 0 && lastDiff < 0))
+            {
+                return false;
+            }
+            else
+            {
+                tail = m_tail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool tryPop(T& value)
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        Slot& slot = m_slots[head & m_mask];
+        if(slot.sequence.load(std::memory_order_acquire) != head + 1) return false;
+
+        value = slot.value;
+        slot.sequence.store(head + m_capacity, std::memory_order_release);
+        m_head.store(head + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    size_t capacity() const
+    {
+        return m_capacity;
+    }
+
+    MPSCQueue(const MPSCQueue& copy) = delete;
+    MPSCQueue& operator=(const MPSCQueue& copy) = delete;
+private:
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    const size_t m_capacity;
+    const size_t m_mask;
+    std::unique_ptr<Slot[]> m_slots;
+
+    alignas(ENGMSC_CACHE_LINE) std::atomic<size_t> m_head{0};
+    alignas(ENGMSC_CACHE_LINE) std::atomic<size_t> m_tail{0};
+};
+
+//Lock-free stack of the indices [0, capacity), used to hand out fixed slots from any thread.
+//The head carries a tag that changes on every pop so a recycled index cannot cause ABA.
+class LockFreeIndexStack
+{
+public:
+    static constexpr uint32_t EMPTY = 0xFFFFFFFF;
+
+    LockFreeIndexStack(size_t capacity) :
+        m_capacity(capacity),
+        m_next(new std::atomic<uint32_t>[capacity])
+    {
+        for(size_t i = 0; i < capacity; i++)
+        {
+            m_next[i].store(i + 1 < capacity ? uint32_t(i + 1) : EMPTY, std::memory_order_relaxed);
+        }
+        m_head.store(capacity > 0 ? 0 : EMPTY, std::memory_order_relaxed);
+    }
+
+    uint32_t pop()
+    {
+        uint64_t head = m_head.load(std::memory_order_acquire);
+        for(;;)
+        {
+            const uint32_t index = uint32_t(head);
+            if(index == EMPTY) return EMPTY;
+
+            const uint64_t next = ((head >> 32) + 1) << 32 | m_next[index].load(std::memory_order_relaxed);
+            if(m_head.compare_exchange_weak(head, next, std::memory_order_acquire, std::memory_order_acquire))
+            {
+                m_size.fetch_sub(1, std::memory_order_relaxed);
+                return index;
+            }
+        }
+    }
+
+    void push(uint32_t index)
+    {
+        uint64_t head = m_head.load(std::memory_order_relaxed);
+        for(;;)
+        {
+            m_next[index].store(uint32_t(head), std::memory_order_relaxed);
+            const uint64_t next = (head & 0xFFFFFFFF00000000ull) | index;
+            if(m_head.compare_exchange_weak(head, next, std::memory_order_release, std::memory_order_relaxed))
+            {
+                m_size.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+    }
+
+    size_t size() const
+    {
+        return m_size.load(std::memory_order_relaxed);
+    }
+
+    size_t capacity() const
+    {
+        return m_capacity;
+    }
+
+    LockFreeIndexStack(const LockFreeIndexStack& copy) = delete;
+    LockFreeIndexStack& operator=(const LockFreeIndexStack& copy) = delete;
+private:
+    const size_t m_capacity;
+    std::unique_ptr<std::atomic<uint32_t>[]> m_next;
+    alignas(ENGMSC_CACHE_LINE) std::atomic<uint64_t> m_head;
+    std::atomic<size_t> m_size{m_capacity};
+};
+
+#endif
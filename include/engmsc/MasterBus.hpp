@@ -0,0 +1,45 @@
+#pragma once
+
+#ifndef MASTER_BUS_HPP
+#define MASTER_BUS_HPP
+
+#include <inttypes.h>
+#include <stddef.h>
+#include <atomic>
+
+#include <engmsc/simd/BiquadCascade.hpp>
+
+//Output chain applied to a stream's mix: high-pass, parallel low-pass boost, then the
+//soft-clipping int16 output stage. Parameters can be changed from any thread; filter
+//coefficients are only recomputed on the render thread when one of them changes.
+class MasterBus
+{
+public:
+    MasterBus(unsigned sampleRate);
+
+    void setHighPassCutoff(double cutoff);
+    void setLowPassCutoff(double cutoff);
+    void setDryGain(float dryGain);
+    double getHighPassCutoff() const;
+    double getLowPassCutoff() const;
+    float getDryGain() const;
+
+    void process(float* mix, int16_t* output, size_t nbSamples);
+
+    MasterBus(const MasterBus& copy) = delete;
+    MasterBus& operator=(const MasterBus& copy) = delete;
+private:
+    const unsigned m_sampleRate;
+
+    std::atomic<double> m_highPassCutoff{20.0};
+    std::atomic<double> m_lowPassCutoff{500.0};
+    std::atomic<float> m_dryGain{0.5f};
+    std::atomic<bool> m_coefficientsDirty{true};
+
+    //4th order Butterworth filters, in double as the 20 Hz high pass needs the precision. The
+    //high pass runs alone in one lane and followed by the low pass in the other.
+    BiquadCascade<double, 2> m_filters;
+    void i_updateCoefficients();
+};
+
+#endif
@@ -0,0 +1,73 @@
+#pragma once
+
+#ifndef MIX_THREAD_POOL_HPP
+#define MIX_THREAD_POOL_HPP
+
+#include <engmsc/RealtimeMode.hpp>
+
+#include <stddef.h>
+#include <atomic>
+#include <vector>
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+//Fork-join pool used to mix voices in parallel. Jobs are claimed from a shared counter by
+//the workers and by the calling thread; each participant accumulates into its own scratch
+//buffer and the scratch buffers are summed into the output with a pairwise tree.
+class MixThreadPool
+{
+public:
+    typedef void (*Job)(void* context, size_t jobIndex, float* scratch, size_t nbSamples);
+
+    //Workers apply the real-time options when they start; worker i is pinned to options.cpu + i
+    MixThreadPool(size_t nbWorkers, size_t maxSamples, const RealtimeOptions& realtimeOptions = RealtimeOptions());
+
+    void run(Job job, void* context, size_t nbJobs, float* output, size_t nbSamples);
+    size_t getNbWorkers() const;
+    RealtimeReport getRealtimeReport();
+
+    MixThreadPool(const MixThreadPool& copy) = delete;
+    MixThreadPool& operator=(const MixThreadPool& copy) = delete;
+
+    ~MixThreadPool();
+private:
+    struct Participant
+    {
+        float* scratch = nullptr;
+        bool used = false;
+    };
+
+    const size_t m_maxSamples;
+    const RealtimeOptions m_realtimeOptions;
+    std::vector<Participant> m_participants;
+    std::vector<float*> m_reduceList;
+    float* m_scratchData;
+
+    Job m_job = nullptr;
+    void* m_jobContext = nullptr;
+    size_t m_nbJobs = 0;
+    size_t m_nbSamples = 0;
+    std::atomic<size_t> m_nextJob{0};
+    std::atomic<size_t> m_workersBusy{0};
+    std::atomic<size_t> m_generation{0};
+
+    //Workers that gave up spinning; run() only takes m_wakeMutex to wake them when this is non-zero
+    std::atomic<size_t> m_nbParked{0};
+    std::atomic<bool> m_running{true};
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wakeCV;
+    std::vector<std::thread*> m_workers;
+
+    std::mutex m_reportMutex;
+    RealtimeReport m_realtimeReport;
+    size_t m_nbReports = 0;
+    bool m_memoryLocked = false;
+
+    void i_workerThread(size_t participant);
+    void i_runJobs(Participant& participant);
+    void i_reduce(float* output);
+};
+
+#endif
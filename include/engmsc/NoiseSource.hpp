@@ -0,0 +1,35 @@
+#pragma once
+
+#ifndef NOISE_SOURCE_HPP
+#define NOISE_SOURCE_HPP
+
+#include <stddef.h>
+#include <inttypes.h>
+
+//Per-voice white noise. Four interleaved xorshift32 generators make one sample each per step,
+//so a block is produced four samples at a time with SSE2; uniform() gives the same sequence
+//for a given seed with or without SIMD. Nothing is shared between instances.
+class NoiseSource
+{
+public:
+    //Seed 0 picks the next seed from a process-wide counter, so every voice sounds different
+    NoiseSource(uint32_t seed = 0);
+
+    void setSeed(uint32_t seed);
+
+    //Uniform in [-1, 1)
+    float nextUniform();
+    void uniform(float* output, size_t nbSamples);
+
+    //Sum of four uniforms scaled to unit variance: a close, bounded (+-3.46) approximation of
+    //a standard normal distribution that needs no log or trig
+    float nextGaussian();
+    void gaussian(float* output, size_t nbSamples);
+private:
+    alignas(16) uint32_t m_state[4];
+    unsigned m_lane = 0;
+
+    inline uint32_t i_nextBits();
+};
+
+#endif
@@ -0,0 +1,48 @@
+#pragma once
+
+#ifndef REALTIME_MODE_HPP
+#define REALTIME_MODE_HPP
+
+#include <stddef.h>
+
+//Opt-in setup for audio threads. Threads read these when they start.
+struct RealtimeOptions
+{
+    bool enabled = false;
+    bool flushDenormals = true;
+    bool fifoScheduling = true;
+    //0 picks the middle of the SCHED_FIFO range
+    int fifoPriority = 0;
+    //First CPU to pin to; threads of the same owner take the following ones. -1 leaves them unpinned.
+    int cpu = -1;
+    bool lockMemory = true;
+};
+
+//Which steps took effect. A step reads false if it was not requested, is not available on
+//this platform or was refused by the OS (no CAP_SYS_NICE, RLIMIT_MEMLOCK too low...).
+struct RealtimeReport
+{
+    bool applied = false;
+    bool denormalsFlushed = false;
+    bool fifoScheduling = false;
+    bool pinned = false;
+    bool memoryLocked = false;
+};
+
+class RealtimeMode
+{
+public:
+    static bool flushDenormals();
+    static bool setFifoScheduling(int priority);
+    static bool pinToCpu(int cpu);
+    static bool lockMemory(const void* data, size_t size);
+    static void unlockMemory(const void* data, size_t size);
+
+    //Runs the per-thread steps (denormals, scheduling, pinning) on the calling thread
+    static RealtimeReport applyToCurrentThread(const RealtimeOptions& options, int cpu);
+
+    //A step of a multi-threaded owner only counts as done if it succeeded on every thread
+    static RealtimeReport combine(const RealtimeReport& a, const RealtimeReport& b);
+};
+
+#endif
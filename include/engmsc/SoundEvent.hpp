@@ -8,14 +8,26 @@
 struct SoundEvent
 {
 public:
-    SoundEvent(IAudioProducer* producer, float volume = 1.0f, float pitch = 1.0f);
+    SoundEvent(IAudioProducer* producer, float volume = 1.0f, float pitch = 1.0f, int priority = 0);
 
     float volume = 1.0f;
     float pitch = 1.0f;
+    //Higher priority voices are kept when the stream steals by priority
+    int priority = 0;
     IAudioProducer* audioProducer = nullptr;
 private:
     friend class AudioStream;
     double m_samplePos = 0.0;
 };
 
+//A sound event and the stream time it starts at, for submitting several in one go
+struct ScheduledEvent
+{
+public:
+    ScheduledEvent(const SoundEvent& event = SoundEvent(nullptr), double seconds = 0.0);
+
+    SoundEvent event;
+    double seconds = 0.0;
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,23 @@
+#pragma once
+
+#ifndef VOICE_HANDLE_HPP
+#define VOICE_HANDLE_HPP
+
+#include <inttypes.h>
+
+//Names one submitted voice of an AudioStream. The generation changes every time the voice
+//slot is reused, so a handle to a voice that already ended is detected instead of aliasing.
+struct VoiceHandle
+{
+    static constexpr uint32_t INVALID_INDEX = 0xFFFFFFFF;
+
+    uint32_t index = INVALID_INDEX;
+    uint32_t generation = 0;
+
+    bool isValid() const
+    {
+        return index != INVALID_INDEX;
+    }
+};
+
+#endif
@@ -0,0 +1,77 @@
+#pragma once
+
+#ifndef VOICE_POOL_HPP
+#define VOICE_POOL_HPP
+
+#include <engmsc/IAudioProducer.hpp>
+#include <engmsc/LockFreeQueue.hpp>
+
+#include <memory>
+#include <new>
+#include <utility>
+#include <type_traits>
+
+class IVoicePool
+{
+public:
+    IVoicePool();
+
+    //Destroys the producer in place and returns its slot to the pool
+    virtual void recycle(IAudioProducer* producer) = 0;
+
+    IVoicePool(const IVoicePool& copy) = delete;
+    void operator=(const IVoicePool& copy) = delete;
+
+    virtual ~IVoicePool();
+};
+
+//Fixed-capacity arena of producers of one type. Slots are claimed and returned through a
+//lock-free index stack, so producers can be created on one thread and recycled on another
+//without touching the heap.
+template<typename T>
+class VoicePool : public IVoicePool
+{
+    static_assert(std::is_base_of<IAudioProducer, T>::value, "VoicePool only holds audio producers");
+public:
+    VoicePool(size_t capacity) :
+        m_slots(new Slot[capacity]),
+        m_freeSlots(capacity) {}
+
+    //Returns nullptr when every slot is in use
+    template<typename... Args>
+    T* create(Args&&... args)
+    {
+        const uint32_t index = m_freeSlots.pop();
+        if(index == LockFreeIndexStack::EMPTY) return nullptr;
+
+        T* producer = new (&m_slots[index]) T(std::forward<Args>(args)...);
+        producer->m_voicePool = this;
+        return producer;
+    }
+
+    virtual void recycle(IAudioProducer* producer) override
+    {
+        T* voice = static_cast<T*>(producer);
+        const uint32_t index = uint32_t((Slot*) voice - m_slots.get());
+
+        voice->~T();
+        m_freeSlots.push(index);
+    }
+
+    size_t getCapacity() const
+    {
+        return m_freeSlots.capacity();
+    }
+
+    size_t getNbFree() const
+    {
+        return m_freeSlots.size();
+    }
+private:
+    typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type Slot;
+
+    std::unique_ptr<Slot[]> m_slots;
+    LockFreeIndexStack m_freeSlots;
+};
+
+#endif
@@ -2,22 +2,40 @@
 #define WIND_PRODUCER_HPP
 
 #include <engmsc/IAudioProducer.hpp>
-#include <iir/Butterworth.h>
+#include <engmsc/NoiseSource.hpp>
+#include <engmsc/simd/BiquadCascade.hpp>
+#include <atomic>
 
 class WindProducer : public IAudioProducer
 {
 public:
+    //Parameters for AudioStream::setParameter()
+    enum Parameter
+    {
+        WIND_VELOCITY
+    };
+
     virtual size_t produceSamples(float* buffer, size_t bufferSize) override;
     virtual size_t addOntoSamples(float* buffer, size_t bufferSize, float gain = 1.0f) override;
     virtual double getDuration() const override;
     virtual bool hasExpired() const override;
+    virtual void setParameter(int parameter, float value) override;
 
+    //Safe to call from any thread; the render side glides to the new velocity
     void setWindVelocity(double windVelocity);
+    void setNoiseSeed(uint32_t seed);
     void expire();
 private:
     bool m_expired = false;
-    Iir::Butterworth::LowPass<4> m_lowPass;
+    //Double precision: the cutoff goes down to 1 Hz, where float sections are far too noisy
+    BiquadCascade<double> m_lowPass;
+    std::atomic<double> m_targetVelocity{0.0};
     double m_windVelocity = 0.0;
+    double m_cutoff = 0.0;
+    unsigned m_filterSampleRate = 0;
+    NoiseSource m_noise;
+
+    void i_updateControls(size_t nbSamples);
 };
 
 #endif
\ No newline at end of file
@@ -4,6 +4,7 @@
 #define AL_AUDIO_CONTEXT_HPP
 
 #include <engmsc/IAudioContext.hpp>
+#include <engmsc/RealtimeMode.hpp>
 
 #ifdef _WIN32
     #include <alc.h>
@@ -17,6 +18,7 @@
 #endif
 
 #include <forward_list>
+#include <vector>
 
 class ALAudioContext : public IAudioContext
 {
@@ -25,6 +27,13 @@ public:
     virtual void addStream(AudioStream& audioStream);
     virtual bool removeStream(AudioStream& audioStream);
     virtual void destroyContext();
+
+    //Must be set before initContext; the worker applies it when it starts
+    void setRealtimeOptions(const RealtimeOptions& options);
+    RealtimeReport getRealtimeReport();
+
+    //Per-stream underruns are also counted into each AudioStream's own stats
+    AudioContextStats getStats() const;
 private:
     ALCdevice* m_alDevice = nullptr;
     ALCcontext* m_alContext = nullptr;
@@ -33,8 +42,8 @@ private:
     {
         AudioStream* audioStream = nullptr;
         ALuint alSource = 0;
-        ALuint alBufferPool[BUFFER_POOL_SIZE];
-        size_t underruns = 0;
+        std::vector<ALuint> alBufferPool;
+        std::vector<ALuint> idleBuffers;
     };
 
     std::mutex m_streamListMutex;
@@ -43,7 +52,14 @@ private:
     std::mutex m_workerMutex;
     std::condition_variable m_workerCV;
     std::thread* m_workerThread;
+    std::chrono::steady_clock::duration m_workerInterval;
     bool m_workerRunning = true;
+    RealtimeOptions m_realtimeOptions;
+    RealtimeReport m_realtimeReport;
+
+    std::atomic<size_t> m_nbStreams{0};
+    std::atomic<size_t> m_nbUnderruns{0};
+    TimingStats m_pollTimes;
     void i_streamWorkerThread();
 };
 
@@ -0,0 +1,79 @@
+#pragma once
+
+#ifndef REALTIME_CHECKER_HPP
+#define REALTIME_CHECKER_HPP
+
+#include <stddef.h>
+#include <stdio.h>
+
+//Built with ENGMSC_RT_CHECKS (CMake option ENGMSC_REALTIME_CHECKS), code inside an
+//ENGMSC_RT_SCOPE that allocates, frees, locks a mutex or makes a blocking call records a
+//violation with its stack. Outside of a violation the only cost is a thread-local check.
+//Without the option the macros expand to nothing and no violation is ever recorded.
+#ifdef ENGMSC_RT_CHECKS
+    #define ENGMSC_RT_SCOPE(name) RealtimeChecker::Scope engmscRealtimeScope(name)
+    #define ENGMSC_RT_ALLOW() RealtimeChecker::Allow engmscRealtimeAllow
+#else
+    #define ENGMSC_RT_SCOPE(name)
+    #define ENGMSC_RT_ALLOW()
+#endif
+
+class RealtimeChecker
+{
+public:
+    enum ViolationType
+    {
+        ALLOCATION,
+        DEALLOCATION,
+        MUTEX_LOCK,
+        BLOCKING_CALL
+    };
+
+    static constexpr int MAX_FRAMES = 24;
+    static constexpr size_t VIOLATION_CAPACITY = 256;
+
+    struct Violation
+    {
+        ViolationType type = ALLOCATION;
+        const char* call = "";
+        const char* scope = "";
+        int nbFrames = 0;
+        void* frames[MAX_FRAMES];
+    };
+
+    //Marks the calling thread as real-time until destroyed; scopes nest
+    class Scope
+    {
+    public:
+        Scope(const char* name);
+        ~Scope();
+    private:
+        const char* m_previousName;
+    };
+
+    //Suspends checking inside a scope for a call that is known and accepted
+    class Allow
+    {
+    public:
+        Allow();
+        ~Allow();
+    };
+
+    static bool isEnabled();
+    static bool isInScope();
+
+    //Violations are kept in a bounded lock-free queue; ones that do not fit are only counted.
+    //Popping is for a single reader thread.
+    static bool popViolation(Violation& violation);
+    static size_t getNbViolations();
+    static size_t getNbDroppedViolations();
+    static const char* getTypeName(ViolationType type);
+
+    //Drains the queue and prints each violation with its symbolized stack. Same reader as popViolation.
+    static void printViolations(FILE* file);
+
+    //Called by the interceptors
+    static void check(ViolationType type, const char* call);
+};
+
+#endif
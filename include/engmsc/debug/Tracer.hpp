@@ -0,0 +1,49 @@
+#pragma once
+
+#ifndef TRACER_HPP
+#define TRACER_HPP
+
+#include <stddef.h>
+#include <inttypes.h>
+#include <atomic>
+#include <ostream>
+
+#define ENGMSC_TRACE_CONCAT_INNER(a, b) a##b
+#define ENGMSC_TRACE_CONCAT(a, b) ENGMSC_TRACE_CONCAT_INNER(a, b)
+
+//Records the enclosing block as one complete event. Names must be string literals or otherwise outlive the tracer.
+#define ENGMSC_TRACE_SCOPE(name) Tracer::Scope ENGMSC_TRACE_CONCAT(engmscTraceScope, __LINE__)(name)
+
+//Flight recorder for timeline traces. Each registered thread writes into its own ring of
+//the most recent events without locks or allocation; writeChromeTrace dumps every ring as
+//Chrome trace-event JSON (chrome://tracing, ui.perfetto.dev). Threads that never called
+//registerThread, or scopes opened while tracing is disabled, record nothing.
+class Tracer
+{
+public:
+    static constexpr size_t EVENTS_PER_THREAD = 65536;
+
+    class Scope
+    {
+    public:
+        Scope(const char* name);
+        ~Scope();
+    private:
+        const char* m_name;
+        int64_t m_start;
+    };
+
+    //Allocates the calling thread's ring, or reuses the one left by an exited thread of the
+    //same name; call once when the thread starts, outside real-time code
+    static void registerThread(const char* name);
+    static void setEnabled(bool enabled);
+    static bool isEnabled();
+
+    static void writeChromeTrace(std::ostream& stream);
+    static bool writeChromeTrace(const char* path);
+private:
+    static int64_t i_now();
+    static void i_record(const char* name, int64_t start, int64_t end);
+};
+
+#endif
@@ -0,0 +1,120 @@
+#pragma once
+
+#ifndef BIQUAD_CASCADE_HPP
+#define BIQUAD_CASCADE_HPP
+
+#include <engmsc/ButterworthDesign.hpp>
+
+#include <stddef.h>
+#include <algorithm>
+#include <type_traits>
+
+//Kernels behind BiquadCascade. A call runs nbSections transposed direct form II sections over
+//nbFrames frames of nbLanes interleaved samples, for lanes [firstLane, nbLanes). Each section
+//holds its coefficients as arrays of nbLanes b0, b1, b2, a1 and a2, then its state as arrays
+//of nbLanes s1 and s2; sections follow each other. Lanes are filtered as many at a time as
+//the widest kernel the CPU supports allows (AVX2: 8 floats or 4 doubles, SSE2: 4 floats or
+//2 doubles) and leftover lanes go through narrower ones.
+class BiquadKernel
+{
+public:
+    typedef void (*FloatKernel)(const float* coefficients, float* state, float* samples, size_t nbFrames, size_t nbLanes, size_t nbSections, size_t firstLane);
+    typedef void (*DoubleKernel)(const double* coefficients, double* state, double* samples, size_t nbFrames, size_t nbLanes, size_t nbSections, size_t firstLane);
+
+    static void process(const float* coefficients, float* state, float* samples, size_t nbFrames, size_t nbLanes, size_t nbSections);
+    static void process(const double* coefficients, double* state, double* samples, size_t nbFrames, size_t nbLanes, size_t nbSections);
+    static const char* getKernelName();
+
+    static void processScalar(const float* coefficients, float* state, float* samples, size_t nbFrames, size_t nbLanes, size_t nbSections, size_t firstLane);
+    static void processScalar(const double* coefficients, double* state, double* samples, size_t nbFrames, size_t nbLanes, size_t nbSections, size_t firstLane);
+    static void processSSE2(const float* coefficients, float* state, float* samples, size_t nbFrames, size_t nbLanes, size_t nbSections, size_t firstLane);
+    static void processSSE2(const double* coefficients, double* state, double* samples, size_t nbFrames, size_t nbLanes, size_t nbSections, size_t firstLane);
+    static void processAVX2(const float* coefficients, float* state, float* samples, size_t nbFrames, size_t nbLanes, size_t nbSections, size_t firstLane);
+    static void processAVX2(const double* coefficients, double* state, double* samples, size_t nbFrames, size_t nbLanes, size_t nbSections, size_t firstLane);
+private:
+    struct Dispatch
+    {
+        FloatKernel floatKernel;
+        DoubleKernel doubleKernel;
+        const char* name;
+    };
+    static const Dispatch& i_getDispatch();
+};
+
+//LANES independent cascades of up to MAX_SECTIONS biquads, in float or double. Lanes can be
+//voices or channels with coefficients of their own; a lane with fewer sections than the others
+//passes through the rest. Sections are run in pairs over the whole block, so their state stays
+//in registers. Nothing allocates and setup() only copies coefficients, so both are safe on the
+//render thread.
+template<typename T, size_t LANES = 1>
+class BiquadCascade
+{
+    static_assert(std::is_same<T, float>::value || std::is_same<T, double>::value, "BiquadCascade filters floats or doubles");
+    static_assert(LANES > 0, "BiquadCascade needs at least one lane");
+public:
+    static constexpr size_t MAX_SECTIONS = ButterworthDesign::MAX_ORDER;
+
+    BiquadCascade()
+    {
+        setup(nullptr, 0);
+        reset();
+    }
+
+    //Same sections for every lane
+    void setup(const BiquadCoefficients* sections, size_t nbSections)
+    {
+        for(size_t lane = 0; lane < LANES; lane++)
+        {
+            setup(lane, sections, nbSections);
+        }
+    }
+
+    //Filter state is kept, so coefficients can change while a signal runs through
+    void setup(size_t lane, const BiquadCoefficients* sections, size_t nbSections)
+    {
+        nbSections = std::min(nbSections, MAX_SECTIONS);
+        for(size_t section = 0; section < MAX_SECTIONS; section++)
+        {
+            const BiquadCoefficients& coefficients = section < nbSections ? sections[section] : BiquadCoefficients();
+            m_coefficients[section][0][lane] = T(coefficients.b0);
+            m_coefficients[section][1][lane] = T(coefficients.b1);
+            m_coefficients[section][2][lane] = T(coefficients.b2);
+            m_coefficients[section][3][lane] = T(coefficients.a1);
+            m_coefficients[section][4][lane] = T(coefficients.a2);
+        }
+
+        m_nbLaneSections[lane] = nbSections;
+        m_nbSections = *std::max_element(m_nbLaneSections, m_nbLaneSections + LANES);
+    }
+
+    void reset()
+    {
+        std::fill(&m_state[0][0][0], &m_state[0][0][0] + MAX_SECTIONS * 2 * LANES, T(0));
+    }
+
+    //Filters nbFrames frames of LANES interleaved samples in place
+    void process(T* samples, size_t nbFrames)
+    {
+        BiquadKernel::process(&m_coefficients[0][0][0], &m_state[0][0][0], samples, nbFrames, LANES, m_nbSections);
+    }
+
+    //Single sample for one-lane cascades, for code that filters sample by sample
+    T filter(T sample)
+    {
+        static_assert(LANES == 1, "filter() is for one-lane cascades");
+        process(&sample, 1);
+        return sample;
+    }
+
+    size_t getNbSections() const
+    {
+        return m_nbSections;
+    }
+private:
+    alignas(32) T m_coefficients[MAX_SECTIONS][5][LANES];
+    alignas(32) T m_state[MAX_SECTIONS][2][LANES];
+    size_t m_nbLaneSections[LANES] = {};
+    size_t m_nbSections = 0;
+};
+
+#endif
@@ -0,0 +1,35 @@
+#pragma once
+
+#ifndef OUTPUT_STAGE_HPP
+#define OUTPUT_STAGE_HPP
+
+#include <inttypes.h>
+#include <stddef.h>
+
+//Final step of the master bus: clamps mixed samples to [-1, 1], runs them through the
+//soft clipper and converts them to saturated int16. The widest kernel the CPU supports
+//(AVX2, SSE2 or scalar) is picked on first use.
+class OutputStage
+{
+public:
+    typedef void (*Kernel)(const float* input, int16_t* output, size_t nbSamples);
+
+    static void process(const float* input, int16_t* output, size_t nbSamples);
+    static const char* getKernelName();
+
+    static void processScalar(const float* input, int16_t* output, size_t nbSamples);
+    static void processSSE2(const float* input, int16_t* output, size_t nbSamples);
+    static void processAVX2(const float* input, int16_t* output, size_t nbSamples);
+
+    static const float SOFT_CLIP_GAIN;
+    static const float OUTPUT_SCALE;
+private:
+    struct Dispatch
+    {
+        Kernel kernel;
+        const char* name;
+    };
+    static const Dispatch& i_getDispatch();
+};
+
+#endif
@@ -0,0 +1,20 @@
+#pragma once
+
+#ifndef SIMD_SUPPORT_HPP
+#define SIMD_SUPPORT_HPP
+
+//SSE2 is part of the x86-64 baseline, so it is used whenever the compiler targets it.
+//ENGMSC_SIMD_AVX2 is defined by the build when AVX2 kernels are compiled in; they are
+//still only called after hasAVX2() confirms the running CPU supports them.
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define ENGMSC_SIMD_SSE2
+#endif
+
+class SimdSupport
+{
+public:
+    static bool hasSSE2();
+    static bool hasAVX2();
+};
+
+#endif
@@ -0,0 +1,104 @@
+#include <engmsc/AudioStats.hpp>
+
+TimingStats::TimingStats()
+{
+    for(std::atomic<uint32_t>& bucket : m_buckets)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+void TimingStats::record(int64_t nanoseconds)
+{
+    //Single writer, so plain load/store pairs are enough and nothing here is a locked RMW
+    const uint64_t duration = nanoseconds > 0 ? uint64_t(nanoseconds) : 0;
+    m_total.store(m_total.load(std::memory_order_relaxed) + duration, std::memory_order_relaxed);
+    if(duration < m_min.load(std::memory_order_relaxed)) m_min.store(duration, std::memory_order_relaxed);
+    if(duration > m_max.load(std::memory_order_relaxed)) m_max.store(duration, std::memory_order_relaxed);
+
+    std::atomic<uint32_t>& bucket = m_buckets[i_bucketFor(duration)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    m_count.store(m_count.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void TimingStats::reset()
+{
+    //Racing a concurrent record() can lose that one sample, which is fine for statistics
+    m_count.store(0, std::memory_order_relaxed);
+    m_total.store(0, std::memory_order_relaxed);
+    m_min.store(UINT64_MAX, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+    for(std::atomic<uint32_t>& bucket : m_buckets)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+size_t TimingStats::getCount() const
+{
+    return size_t(m_count.load(std::memory_order_acquire));
+}
+
+double TimingStats::getMin() const
+{
+    const uint64_t min = m_min.load(std::memory_order_relaxed);
+    return min == UINT64_MAX ? 0.0 : double(min) * 1e-9;
+}
+
+double TimingStats::getAverage() const
+{
+    const uint64_t count = m_count.load(std::memory_order_acquire);
+    return count ? double(m_total.load(std::memory_order_relaxed)) * 1e-9 / double(count) : 0.0;
+}
+
+double TimingStats::getMax() const
+{
+    return double(m_max.load(std::memory_order_relaxed)) * 1e-9;
+}
+
+double TimingStats::getPercentile(double percentile) const
+{
+    uint64_t count = 0;
+    for(const std::atomic<uint32_t>& bucket : m_buckets)
+    {
+        count += bucket.load(std::memory_order_relaxed);
+    }
+    if(count == 0) return 0.0;
+
+    const uint64_t rank = uint64_t(double(count) * percentile / 100.0);
+    uint64_t seen = 0;
+    for(size_t i = 0; i < NB_BUCKETS; i++)
+    {
+        seen += m_buckets[i].load(std::memory_order_relaxed);
+        if(seen > rank)
+        {
+            //The bucket bound can overshoot the largest sample actually seen
+            const uint64_t max = m_max.load(std::memory_order_relaxed);
+            const uint64_t bound = i_bucketUpperBound(i);
+            return double(bound < max ? bound : max) * 1e-9;
+        }
+    }
+    return getMax();
+}
+
+size_t TimingStats::i_bucketFor(uint64_t nanoseconds)
+{
+    //Below 2^SUB_BUCKET_BITS every value has its own bucket
+    if(nanoseconds < (1u << SUB_BUCKET_BITS)) return size_t(nanoseconds);
+
+    int msb = 63;
+    while(!(nanoseconds >> msb)) msb--;
+
+    const size_t subBucket = size_t(nanoseconds >> (msb - SUB_BUCKET_BITS)) & ((1u << SUB_BUCKET_BITS) - 1);
+    const size_t bucket = (size_t(msb - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS) + subBucket;
+    return bucket < NB_BUCKETS ? bucket : NB_BUCKETS - 1;
+}
+
+uint64_t TimingStats::i_bucketUpperBound(size_t bucket)
+{
+    if(bucket < (1u << SUB_BUCKET_BITS)) return bucket;
+
+    const int msb = int(bucket >> SUB_BUCKET_BITS) + SUB_BUCKET_BITS - 1;
+    const uint64_t subBucket = bucket & ((1u << SUB_BUCKET_BITS) - 1);
+    return ((uint64_t(1) << SUB_BUCKET_BITS | subBucket) + 1) << (msb - SUB_BUCKET_BITS);
+}
@@ -1,70 +1,216 @@
 #include <engmsc/AudioStream.hpp>
+#include <engmsc/simd/OutputStage.hpp>
+#include <engmsc/debug/RealtimeChecker.hpp>
+#include <engmsc/debug/Tracer.hpp>
 #include <chrono>
+#include <algorithm>
+#include <cstring>
 #include <math.h>
 
-typedef std::chrono::high_resolution_clock MainClock;
+typedef std::chrono::steady_clock MainClock;
+
+static const size_t EVENT_QUEUE_CAPACITY = 4096;
+static const size_t MAX_VOICES = 4096;
+static const size_t RETIRE_QUEUE_CAPACITY = 4096;
+
+static const std::chrono::milliseconds HOUSEKEEPING_INTERVAL(10);
 
-static const double BUFFER_DURATION = double(SAMPLES_PER_BUFFER) / SAMPLE_RATE;
+//Below this many active voices the mix stays on the render thread; the fork-join costs more than it saves
+static const size_t PARALLEL_MIX_THRESHOLD = 32;
+static const size_t VOICES_PER_MIX_JOB = 8;
 
-static const MainClock::duration WORKER_INTERVAL = std::chrono::duration_cast<MainClock::duration>(
-    std::chrono::duration<double>(BUFFER_DURATION / 4.0)
-);
+//Length of the fade applied to stolen and stopped voices
+static const double VOICE_FADE_TIME = 0.005;
 
-static const double COMPENSAION_DELAY = BUFFER_DURATION * BUFFER_POOL_SIZE * 1.2;
+//Fraction of the measured clock error folded into the timeline epoch each buffer
+static const double CLOCK_SLEW = 0.02;
 
-AudioStream::AudioStream() :
-    m_bufferPoolData(new uint16_t[SAMPLES_PER_BUFFER * BUFFER_POOL_SIZE]),
-    m_timeStreamStarted(MainClock::now().time_since_epoch().count()),
-    m_workBuffer(new float[SAMPLES_PER_BUFFER]),
-    m_bufferTime(-COMPENSAION_DELAY)
+AudioStream::AudioStream(unsigned sampleRate, size_t samplesPerBuffer, size_t bufferPoolSize) :
+    m_sampleRate(sampleRate),
+    m_samplesPerBuffer(samplesPerBuffer),
+    m_bufferPoolSize(bufferPoolSize),
+    m_bufferDuration(double(samplesPerBuffer) / sampleRate),
+    m_compensationDelay(m_bufferDuration * bufferPoolSize * 1.2),
+    //Events arriving later than this are dropped instead of started late
+    m_maxEventLateness(int64_t(m_compensationDelay * sampleRate)),
+    //The soft clipper's small-signal gain maps this to half an int16 step at the output
+    m_cullLevel(0.5f / (OutputStage::SOFT_CLIP_GAIN * OutputStage::OUTPUT_SCALE)),
+    m_fadeSamples(std::max<size_t>(1, std::min(samplesPerBuffer, size_t(VOICE_FADE_TIME * sampleRate)))),
+    m_commandQueue(EVENT_QUEUE_CAPACITY),
+    m_retiredProducers(RETIRE_QUEUE_CAPACITY),
+    m_freeVoices(MAX_VOICES),
+    m_voiceGenerations(new std::atomic<uint32_t>[MAX_VOICES]),
+    m_voiceControls(MAX_VOICES),
+    m_readyBuffers(bufferPoolSize),
+    m_freeBuffers(bufferPoolSize),
+    m_bufferPoolData(new int16_t[samplesPerBuffer * bufferPoolSize]),
+    m_bufferPool(bufferPoolSize),
+    m_timeStreamStarted(MainClock::now()),
+    m_timelineEpoch(-m_compensationDelay),
+    m_masterBus(sampleRate),
+    m_workBuffer(new float[samplesPerBuffer]),
+    m_fadeBuffer(new float[m_fadeSamples])
 {
-    for(int i = 0; i < BUFFER_POOL_SIZE; i++)
+    m_pendingSounds.reserve(MAX_VOICES);
+    m_activeSounds.reserve(MAX_VOICES);
+    m_fadingSounds.reserve(MAX_VOICES);
+    for(size_t i = 0; i < MAX_VOICES; i++)
+    {
+        m_voiceGenerations[i].store(0, std::memory_order_relaxed);
+    }
+
+    for(size_t i = 0; i < m_bufferPoolSize; i++)
     {
-        m_bufferPool[i].id = i;
-        m_bufferPool[i].data = m_bufferPoolData + SAMPLES_PER_BUFFER * i;
-        m_inputBufferQueue.push(&m_bufferPool[i]);
+        m_bufferPool[i].id = int(i);
+        m_bufferPool[i].data = m_bufferPoolData + m_samplesPerBuffer * i;
+        m_freeBuffers.tryPush(&m_bufferPool[i]);
     }
+
+    m_housekeepingThread = new std::thread(&AudioStream::i_housekeepingThread, this);
 }
 
-void AudioStream::playEvent(const SoundEvent& soundEvent)
+VoiceHandle AudioStream::playEvent(const SoundEvent& soundEvent)
 {
-    m_nbSounds++;
-    std::unique_lock<std::mutex> lock(m_soundsMutex);
-    m_activeSounds.emplace_front(soundEvent, getTime());
+    return i_submitEvent(soundEvent, getSampleTime());
 }
 
-void AudioStream::playEventAt(const SoundEvent& soundEvent, double seconds)
+VoiceHandle AudioStream::playEventAt(const SoundEvent& soundEvent, double seconds)
 {
-    m_nbSounds++;
-    std::unique_lock<std::mutex> lock(m_soundsMutex);
-    m_activeSounds.emplace_front(soundEvent, seconds);
+    return i_submitEvent(soundEvent, timeToSample(seconds));
 }
 
-void AudioStream::playEventIn(const SoundEvent& soundEvent, double seconds)
+VoiceHandle AudioStream::playEventIn(const SoundEvent& soundEvent, double seconds)
 {
-    m_nbSounds++;
-    std::unique_lock<std::mutex> lock(m_soundsMutex);
-    m_activeSounds.emplace_front(soundEvent, getTime() + seconds);
+    return i_submitEvent(soundEvent, timeToSample(getTime() + seconds));
+}
+
+VoiceHandle AudioStream::playEventAtSample(const SoundEvent& soundEvent, int64_t sample)
+{
+    return i_submitEvent(soundEvent, sample);
+}
+
+size_t AudioStream::playEvents(const ScheduledEvent* events, size_t nbEvents, VoiceHandle* voices)
+{
+    Command commands[SUBMIT_BATCH_SIZE];
+    size_t nbQueued = 0;
+
+    for(size_t first = 0; first < nbEvents; first += SUBMIT_BATCH_SIZE)
+    {
+        const size_t count = std::min(nbEvents - first, SUBMIT_BATCH_SIZE);
+        size_t nbCommands = 0;
+        for(size_t i = 0; i < count; i++)
+        {
+            const ScheduledEvent& scheduled = events[first + i];
+            const VoiceHandle voice = i_makePlayCommand(scheduled.event, timeToSample(scheduled.seconds), commands[nbCommands]);
+            if(voices) voices[first + i] = voice;
+            if(voice.isValid()) nbCommands++;
+        }
+
+        //Counted before the push, as in i_submitEvent
+        m_nbSounds += nbCommands;
+        //Same policy as single events: never wait on the render thread, drop the batch instead
+        if(!m_commandQueue.tryPushBatch(commands, nbCommands))
+        {
+            m_nbSounds -= nbCommands;
+            for(size_t i = 0; i < nbCommands; i++)
+            {
+                i_cancelPlayCommand(commands[i]);
+            }
+            if(voices) std::fill(voices + first, voices + first + count, VoiceHandle());
+            continue;
+        }
+        nbQueued += nbCommands;
+    }
+    return nbQueued;
+}
+
+bool AudioStream::stop(VoiceHandle voice)
+{
+    return i_submitControl(Command::STOP, voice, 0.0f);
+}
+
+bool AudioStream::setVolume(VoiceHandle voice, float volume)
+{
+    return i_submitControl(Command::SET_VOLUME, voice, volume);
+}
+
+bool AudioStream::setPitch(VoiceHandle voice, float pitch)
+{
+    return i_submitControl(Command::SET_PITCH, voice, pitch);
+}
+
+bool AudioStream::setParameter(VoiceHandle voice, int parameter, float value)
+{
+    return i_submitControl(Command::SET_PARAMETER, voice, value, parameter);
+}
+
+bool AudioStream::isPlaying(VoiceHandle voice) const
+{
+    if(!voice.isValid() || voice.index >= MAX_VOICES) return false;
+    return m_voiceGenerations[voice.index].load(std::memory_order_acquire) == voice.generation;
+}
+
+size_t AudioStream::i_nextVoicePoolSlot()
+{
+    static std::atomic<size_t> nextSlot{0};
+    return nextSlot.fetch_add(1, std::memory_order_relaxed);
 }
 
 const int16_t* AudioStream::getNextBuffer()
 {
-    if(m_outputBufferQueue.empty())
+    const int16_t* nextData = tryGetNextBuffer();
+    while(!nextData)
     {
-        i_fillNextBuffers();
+        std::this_thread::yield();
+        nextData = tryGetNextBuffer();
     }
+    return nextData;
+}
 
-    const uint16_t* nextData = m_outputBufferQueue.front()->data;
-    m_inputBufferQueue.push(m_outputBufferQueue.front());
-    m_outputBufferQueue.pop();
+const int16_t* AudioStream::tryGetNextBuffer()
+{
+    ENGMSC_RT_SCOPE("AudioStream::tryGetNextBuffer");
 
-    return (const int16_t*) nextData;
+    //Announced before the mode is read, so a mode change either waits for this call or is seen by it
+    m_consumerActive.store(true, std::memory_order_seq_cst);
+    const int mode = m_renderMode.load(std::memory_order_seq_cst);
+
+    Buffer* buffer = nullptr;
+    if(mode != RENDER_PAUSED)
+    {
+        //The previously returned buffer may still have been read by the caller until now
+        i_releaseHeldBuffer();
+
+        //With a render thread a missing block is the caller's underrun; never render here
+        if(!m_readyBuffers.tryPop(buffer) && mode == RENDER_INLINE && i_renderNextBuffer())
+        {
+            m_readyBuffers.tryPop(buffer);
+        }
+        m_heldBuffer = buffer;
+    }
+
+    m_consumerActive.store(false, std::memory_order_release);
+    return buffer ? buffer->data : nullptr;
 }
 
 double AudioStream::getTime()
 {
-    size_t now = MainClock::now().time_since_epoch().count();
-    return (now - m_timeStreamStarted) / 10e8;
+    return std::chrono::duration<double>(MainClock::now() - m_timeStreamStarted).count();
+}
+
+int64_t AudioStream::getSampleTime()
+{
+    return timeToSample(getTime());
+}
+
+int64_t AudioStream::timeToSample(double seconds) const
+{
+    return llround((seconds - m_timelineEpoch.load(std::memory_order_relaxed)) * m_sampleRate);
+}
+
+double AudioStream::sampleToTime(int64_t sample) const
+{
+    return double(sample) / m_sampleRate + m_timelineEpoch.load(std::memory_order_relaxed);
 }
 
 size_t AudioStream::getNbSounds() const
@@ -72,91 +218,773 @@ size_t AudioStream::getNbSounds() const
     return m_nbSounds;
 }
 
+size_t AudioStream::getNbLateEvents() const
+{
+    return m_nbLateEvents.load(std::memory_order_relaxed);
+}
+
+size_t AudioStream::getNbDroppedEvents() const
+{
+    return m_nbDroppedEvents.load(std::memory_order_relaxed);
+}
+
+int64_t AudioStream::getMaxLateness() const
+{
+    return m_maxLateness.load(std::memory_order_relaxed);
+}
+
+unsigned AudioStream::getSampleRate() const
+{
+    return m_sampleRate;
+}
+
+size_t AudioStream::getSamplesPerBuffer() const
+{
+    return m_samplesPerBuffer;
+}
+
+size_t AudioStream::getBufferPoolSize() const
+{
+    return m_bufferPoolSize;
+}
+
+double AudioStream::getBufferDuration() const
+{
+    return m_bufferDuration;
+}
+
+MasterBus& AudioStream::getMasterBus()
+{
+    return m_masterBus;
+}
+
+void AudioStream::setMaxPolyphony(size_t maxVoices)
+{
+    m_maxPolyphony.store(maxVoices, std::memory_order_relaxed);
+}
+
+size_t AudioStream::getMaxPolyphony() const
+{
+    return m_maxPolyphony.load(std::memory_order_relaxed);
+}
+
+void AudioStream::setVoiceStealing(VoiceStealing policy)
+{
+    m_voiceStealing.store(policy, std::memory_order_relaxed);
+}
+
+AudioStream::VoiceStealing AudioStream::getVoiceStealing() const
+{
+    return m_voiceStealing.load(std::memory_order_relaxed);
+}
+
+size_t AudioStream::getNbStolenVoices() const
+{
+    return m_nbStolenVoices.load(std::memory_order_relaxed);
+}
+
+size_t AudioStream::getNbRefusedVoices() const
+{
+    return m_nbRefusedVoices.load(std::memory_order_relaxed);
+}
+
+void AudioStream::setCullLevel(float level)
+{
+    m_cullLevel.store(level, std::memory_order_relaxed);
+}
+
+float AudioStream::getCullLevel() const
+{
+    return m_cullLevel.load(std::memory_order_relaxed);
+}
+
+void AudioStream::setLowDetailLevel(float level)
+{
+    m_lowDetailLevel.store(level, std::memory_order_relaxed);
+}
+
+float AudioStream::getLowDetailLevel() const
+{
+    return m_lowDetailLevel.load(std::memory_order_relaxed);
+}
+
+size_t AudioStream::getNbCulledVoices() const
+{
+    return m_nbCulledVoices.load(std::memory_order_relaxed);
+}
+
+AudioStreamStats AudioStream::getStats() const
+{
+    AudioStreamStats stats;
+    stats.nbBlocks = m_renderTimes.getCount();
+    stats.renderTimeMin = m_renderTimes.getMin();
+    stats.renderTimeAvg = m_renderTimes.getAverage();
+    stats.renderTimeP99 = m_renderTimes.getPercentile(99.0);
+    stats.renderTimeMax = m_renderTimes.getMax();
+    stats.dspLoad = stats.renderTimeAvg / m_bufferDuration * 100.0;
+    stats.dspLoadP99 = stats.renderTimeP99 / m_bufferDuration * 100.0;
+    stats.dspLoadPeak = stats.renderTimeMax / m_bufferDuration * 100.0;
+
+    stats.activeVoices = m_nbActiveVoices.load(std::memory_order_relaxed);
+    stats.pendingVoices = m_nbPendingVoices.load(std::memory_order_relaxed);
+    stats.lateEvents = m_nbLateEvents.load(std::memory_order_relaxed);
+    stats.droppedEvents = m_nbDroppedEvents.load(std::memory_order_relaxed);
+    stats.stolenVoices = m_nbStolenVoices.load(std::memory_order_relaxed);
+    stats.refusedVoices = m_nbRefusedVoices.load(std::memory_order_relaxed);
+    stats.culledVoices = m_nbCulledVoices.load(std::memory_order_relaxed);
+    stats.resyncs = m_nbResyncs.load(std::memory_order_relaxed);
+    stats.underruns = m_nbUnderruns.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void AudioStream::resetStats()
+{
+    m_renderTimes.reset();
+}
+
 AudioStream::~AudioStream()
 {
+    stopRenderThread();
+    delete m_mixThreadPool;
+
+    i_drainCommandQueue();
+    for(TimedSoundEvent& sound : m_pendingSounds)
+    {
+        IAudioProducer::dispose(sound.event.audioProducer);
+    }
+    for(TimedSoundEvent& sound : m_activeSounds)
+    {
+        IAudioProducer::dispose(sound.event.audioProducer);
+    }
+    for(TimedSoundEvent& sound : m_fadingSounds)
+    {
+        IAudioProducer::dispose(sound.event.audioProducer);
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(m_housekeepingMutex);
+        m_housekeepingRunning = false;
+    }
+    m_housekeepingCV.notify_all();
+    m_housekeepingThread->join();
+    delete m_housekeepingThread;
+    i_disposeRetiredProducers();
+
+    if(m_realtimeOptions.enabled && m_realtimeOptions.lockMemory) i_lockMemory(false);
     delete[] m_bufferPoolData;
     delete[] m_workBuffer;
+    delete[] m_fadeBuffer;
 }
 
-AudioStream::TimedSoundEvent::TimedSoundEvent(const SoundEvent& p_event, double p_time) :
+AudioStream::TimedSoundEvent::TimedSoundEvent() :
+    event(nullptr) {}
+
+AudioStream::TimedSoundEvent::TimedSoundEvent(const SoundEvent& p_event, int64_t p_sample) :
     event(p_event),
-    timeToPlay(p_time) {}
+    sampleToPlay(p_sample) {}
 
-#include <cstring>
-#include <Iir.h>
-Iir::Butterworth::HighPass<4> highPass;
-Iir::Butterworth::LowPass<4> lowPass;
+bool AudioStream::LaterSoundEvent::operator()(const TimedSoundEvent& a, const TimedSoundEvent& b) const
+{
+    return a.sampleToPlay > b.sampleToPlay;
+}
+
+VoiceHandle AudioStream::i_submitEvent(const SoundEvent& soundEvent, int64_t sample)
+{
+    Command command;
+    VoiceHandle voice = i_makePlayCommand(soundEvent, sample, command);
+    if(!voice.isValid()) return voice;
+
+    //Counted before the push: once published, the render thread may end the voice and decrement
+    m_nbSounds++;
+
+    //Never wait on the render thread; if it has fallen this far behind the event is dropped
+    if(!m_commandQueue.tryPush(command))
+    {
+        m_nbSounds--;
+        i_cancelPlayCommand(command);
+        return VoiceHandle();
+    }
+    return voice;
+}
+
+VoiceHandle AudioStream::i_makePlayCommand(const SoundEvent& soundEvent, int64_t sample, Command& command)
+{
+    VoiceHandle voice;
+    if(!soundEvent.audioProducer) return voice;
+
+    voice.index = m_freeVoices.pop();
+    if(voice.index == LockFreeIndexStack::EMPTY)
+    {
+        IAudioProducer::dispose(soundEvent.audioProducer);
+        return VoiceHandle();
+    }
+    voice.generation = m_voiceGenerations[voice.index].load(std::memory_order_acquire);
+
+    command.type = Command::PLAY;
+    command.voice = voice;
+    command.sound = TimedSoundEvent(soundEvent, sample);
+    command.sound.voice = voice.index;
+    return voice;
+}
+
+void AudioStream::i_cancelPlayCommand(const Command& command)
+{
+    IAudioProducer::dispose(command.sound.event.audioProducer);
+    m_freeVoices.push(command.voice.index);
+}
+
+bool AudioStream::i_submitControl(Command::Type type, VoiceHandle voice, float value, int parameter)
+{
+    if(!isPlaying(voice)) return false;
+
+    Command command;
+    command.type = type;
+    command.voice = voice;
+    command.parameter = parameter;
+    command.value = value;
+    return m_commandQueue.tryPush(command);
+}
+
+void AudioStream::i_drainCommandQueue()
+{
+    Command command;
+    while(m_commandQueue.tryPop(command))
+    {
+        i_applyCommand(command);
+    }
+}
+
+void AudioStream::i_applyCommand(const Command& command)
+{
+    if(command.type == Command::PLAY)
+    {
+        const TimedSoundEvent& sound = command.sound;
+        VoiceControl& control = m_voiceControls[sound.voice];
+        control.volume = sound.event.volume;
+        control.pitch = sound.event.pitch;
+        control.stopped = false;
+        control.producer = sound.event.audioProducer;
+
+        sound.event.audioProducer->setSampleRate(m_sampleRate);
+        sound.event.audioProducer->setPitch(sound.event.pitch);
+        m_pendingSounds.push_back(sound);
+        std::push_heap(m_pendingSounds.begin(), m_pendingSounds.end(), LaterSoundEvent());
+        return;
+    }
+
+    //The generation only moves on this thread, so a match here means the voice is still alive
+    if(m_voiceGenerations[command.voice.index].load(std::memory_order_relaxed) != command.voice.generation) return;
+
+    VoiceControl& control = m_voiceControls[command.voice.index];
+    switch(command.type)
+    {
+    case Command::STOP:          control.stopped = true;         break;
+    case Command::SET_VOLUME:    control.volume = command.value; break;
+    case Command::SET_PITCH:     control.pitch = command.value;  break;
+    case Command::SET_PARAMETER: control.producer->setParameter(command.parameter, command.value); break;
+    default: break;
+    }
+}
+
+void AudioStream::i_endVoice(TimedSoundEvent& sound)
+{
+    m_nbSounds--;
+    i_retireProducer(sound.event.audioProducer);
+
+    //Bumping the generation invalidates every outstanding handle before the slot is reused
+    m_voiceGenerations[sound.voice].fetch_add(1, std::memory_order_release);
+    m_freeVoices.push(sound.voice);
+}
 
-#define sg 6.0
-#define S(x) ( (sg * x) / (1.0 + abs(sg * x)) )
+void AudioStream::i_startPendingSounds()
+{
+    const int64_t bufferEnd = m_bufferSample + m_samplesPerBuffer;
+
+    //Pending sounds are a min-heap on start sample, so only the ones due this buffer are visited.
+    //Each onset splits the buffer: the voice only renders from its own offset to the end.
+    while(!m_pendingSounds.empty() && m_pendingSounds.front().sampleToPlay < bufferEnd)
+    {
+        std::pop_heap(m_pendingSounds.begin(), m_pendingSounds.end(), LaterSoundEvent());
+        TimedSoundEvent sound = m_pendingSounds.back();
+        m_pendingSounds.pop_back();
+
+        const VoiceControl& control = m_voiceControls[sound.voice];
+        if(control.stopped)
+        {
+            i_endVoice(sound);
+            continue;
+        }
+
+        //Late events start at the top of the buffer and report by how much they missed
+        size_t sampleStart = 0;
+        if(sound.sampleToPlay < m_bufferSample)
+        {
+            const int64_t lateness = m_bufferSample - sound.sampleToPlay;
+            if(lateness > m_maxEventLateness)
+            {
+                m_nbDroppedEvents++;
+                i_endVoice(sound);
+                continue;
+            }
+
+            m_nbLateEvents++;
+            if(lateness > m_maxLateness.load(std::memory_order_relaxed))
+            {
+                m_maxLateness.store(lateness, std::memory_order_relaxed);
+            }
+        }
+        else
+        {
+            sampleStart = size_t(sound.sampleToPlay - m_bufferSample);
+        }
+
+        //Nothing was stolen: the new voice ranked below every active one
+        if(!i_stealVoiceFor(sound))
+        {
+            m_nbRefusedVoices++;
+            i_endVoice(sound);
+            continue;
+        }
+
+        {
+            ENGMSC_TRACE_SCOPE("addOntoSamples");
+            sound.event.audioProducer->setPitch(control.pitch);
+            sound.event.audioProducer->addOntoSamples(m_workBuffer + sampleStart, m_samplesPerBuffer - sampleStart, control.volume);
+        }
+        m_activeSounds.push_back(sound);
+    }
+}
 
-void AudioStream::i_fillNextBuffers()
+void AudioStream::i_removeExpiredSounds()
 {
-    highPass.setup(SAMPLE_RATE, 20.0);
-    lowPass.setup(SAMPLE_RATE, 500.0);
+    const float cullLevel = m_cullLevel.load(std::memory_order_relaxed);
+    const float lowDetailLevel = m_lowDetailLevel.load(std::memory_order_relaxed);
 
-    while(m_inputBufferQueue.size() > 0)
+    for(size_t i = 0; i < m_activeSounds.size();)
     {
-        Buffer& currentBuffer = *m_inputBufferQueue.front();
-        memset(m_workBuffer, 0, SAMPLES_PER_BUFFER * sizeof(float));
+        TimedSoundEvent& sound = m_activeSounds[i];
+        IAudioProducer* producer = sound.event.audioProducer;
+        const VoiceControl& control = m_voiceControls[sound.voice];
+        if(producer->hasExpired())
+        {
+            i_endVoice(sound);
+            m_activeSounds[i] = m_activeSounds.back();
+            m_activeSounds.pop_back();
+            continue;
+        }
+        if(control.stopped)
+        {
+            i_fadeOutVoice(i);
+            continue;
+        }
 
+        //Inaudible voices end without a fade; there is nothing left to click
+        const float level = std::fabs(control.volume) * producer->getPeakLevel();
+        if(level < cullLevel)
         {
-            std::unique_lock<std::mutex> lock1(m_soundsMutex);
-            for(TimedSoundEvent& sound : m_activeSounds)
+            m_nbCulledVoices++;
+            i_endVoice(sound);
+            m_activeSounds[i] = m_activeSounds.back();
+            m_activeSounds.pop_back();
+            continue;
+        }
+        producer->setLowDetail(level < lowDetailLevel);
+        i++;
+    }
+}
+
+bool AudioStream::i_stealVoiceFor(const TimedSoundEvent& sound)
+{
+    const size_t maxPolyphony = m_maxPolyphony.load(std::memory_order_relaxed);
+    const VoiceStealing policy = m_voiceStealing.load(std::memory_order_relaxed);
+
+    //The limit may have been lowered since the last onset, so keep stealing until there is room
+    while(maxPolyphony && m_activeSounds.size() >= maxPolyphony)
+    {
+        size_t victim = 0;
+        float victimLevel = INFINITY;
+        for(size_t i = 0; i < m_activeSounds.size(); i++)
+        {
+            const TimedSoundEvent& candidate = m_activeSounds[i];
+            const TimedSoundEvent& current = m_activeSounds[victim];
+            switch(policy)
             {
-                if(!sound.hasStarted && m_bufferTime < sound.timeToPlay && sound.timeToPlay < m_bufferTime + BUFFER_DURATION)
-                {
-                    sound.hasStarted = true;
-                    int sampleStart = (sound.timeToPlay - m_bufferTime) * SAMPLE_RATE;
-                    sound.event.audioProducer->addOntoSamples(m_workBuffer + sampleStart, SAMPLES_PER_BUFFER - sampleStart, sound.event.volume);
-                    continue;
-                }
-                else if(sound.hasStarted)
+            case STEAL_OLDEST:
+                if(candidate.sampleToPlay < current.sampleToPlay) victim = i;
+                break;
+            case STEAL_QUIETEST:
+            {
+                const float level = std::fabs(m_voiceControls[candidate.voice].volume) * candidate.event.audioProducer->getPeakLevel();
+                if(level < victimLevel)
                 {
-                    sound.event.audioProducer->addOntoSamples(m_workBuffer, SAMPLES_PER_BUFFER, sound.event.volume);
+                    victim = i;
+                    victimLevel = level;
                 }
+                break;
             }
-            m_activeSounds.remove_if([&](TimedSoundEvent& e)
-            {
-                if(e.event.audioProducer->hasExpired() || !e.hasStarted && e.timeToPlay < m_bufferTime)
+            case STEAL_LOWEST_PRIORITY:
+                //Ties go to the oldest voice
+                if(candidate.event.priority < current.event.priority ||
+                   (candidate.event.priority == current.event.priority && candidate.sampleToPlay < current.sampleToPlay))
                 {
-                    m_nbSounds--;
-                    delete e.event.audioProducer;
-                    return true;
+                    victim = i;
                 }
-                return false;
-            });
-            if(getTime() - m_bufferTime > COMPENSAION_DELAY * 3.0)
-            {
-                m_activeSounds.remove_if([](TimedSoundEvent& e)
-                {
-                    return e.event.audioProducer->getDuration() > 0.0;
-                });
-                m_bufferTime  = getTime() - COMPENSAION_DELAY;
+                break;
             }
         }
 
-        for(int i = 0; i < SAMPLES_PER_BUFFER; i++)
+        if(policy == STEAL_LOWEST_PRIORITY && m_activeSounds[victim].event.priority > sound.event.priority) return false;
+
+        m_nbStolenVoices++;
+        i_fadeOutVoice(victim);
+    }
+    return true;
+}
+
+void AudioStream::i_fadeOutVoice(size_t activeIndex)
+{
+    m_fadingSounds.push_back(m_activeSounds[activeIndex]);
+    m_activeSounds[activeIndex] = m_activeSounds.back();
+    m_activeSounds.pop_back();
+}
+
+void AudioStream::i_mixFadingSounds(size_t nbSamples)
+{
+    //Each fading voice renders one short ramp down to silence at the top of the block and ends
+    const size_t fadeSamples = std::min(nbSamples, m_fadeSamples);
+    const float step = 1.0f / float(fadeSamples);
+    for(TimedSoundEvent& sound : m_fadingSounds)
+    {
+        memset(m_fadeBuffer, 0, fadeSamples * sizeof(float));
+        {
+            ENGMSC_TRACE_SCOPE("addOntoSamples (fade out)");
+            sound.event.audioProducer->setPitch(m_voiceControls[sound.voice].pitch);
+            sound.event.audioProducer->addOntoSamples(m_fadeBuffer, fadeSamples, m_voiceControls[sound.voice].volume);
+        }
+        for(size_t i = 0; i < fadeSamples; i++)
+        {
+            m_workBuffer[i] += m_fadeBuffer[i] * (1.0f - float(i + 1) * step);
+        }
+        i_endVoice(sound);
+    }
+    m_fadingSounds.clear();
+}
+
+void AudioStream::i_retireProducer(IAudioProducer* producer)
+{
+    //Destructors run on the housekeeping thread, never inside a buffer deadline. Only if
+    //that thread has fallen a whole queue behind is the producer disposed of right here.
+    if(!m_retiredProducers.tryPush(producer))
+    {
+        IAudioProducer::dispose(producer);
+    }
+}
+
+void AudioStream::i_disposeRetiredProducers()
+{
+    IAudioProducer* producer;
+    while(m_retiredProducers.tryPop(producer))
+    {
+        IAudioProducer::dispose(producer);
+    }
+}
+
+void AudioStream::i_housekeepingThread()
+{
+    std::unique_lock<std::mutex> lock(m_housekeepingMutex);
+    while(m_housekeepingRunning)
+    {
+        lock.unlock();
+        i_disposeRetiredProducers();
+        lock.lock();
+
+        m_housekeepingCV.wait_for(lock, HOUSEKEEPING_INTERVAL);
+    }
+}
+
+void AudioStream::i_mixActiveSounds(size_t nbSamples)
+{
+    if(!m_mixThreadPool || m_activeSounds.size() < PARALLEL_MIX_THRESHOLD)
+    {
+        for(TimedSoundEvent& sound : m_activeSounds)
+        {
+            ENGMSC_TRACE_SCOPE("addOntoSamples");
+            const VoiceControl& control = m_voiceControls[sound.voice];
+            sound.event.audioProducer->setPitch(control.pitch);
+            sound.event.audioProducer->addOntoSamples(m_workBuffer, nbSamples, control.volume);
+        }
+        return;
+    }
+
+    const size_t nbJobs = (m_activeSounds.size() + VOICES_PER_MIX_JOB - 1) / VOICES_PER_MIX_JOB;
+    m_mixThreadPool->run(&AudioStream::i_mixSoundsJob, this, nbJobs, m_workBuffer, nbSamples);
+}
+
+void AudioStream::i_mixSoundsJob(void* stream, size_t jobIndex, float* scratch, size_t nbSamples)
+{
+    AudioStream& audioStream = *(AudioStream*) stream;
+    std::vector<TimedSoundEvent>& sounds = audioStream.m_activeSounds;
+
+    const size_t end = std::min(sounds.size(), (jobIndex + 1) * VOICES_PER_MIX_JOB);
+    for(size_t i = jobIndex * VOICES_PER_MIX_JOB; i < end; i++)
+    {
+        ENGMSC_TRACE_SCOPE("addOntoSamples");
+        const VoiceControl& control = audioStream.m_voiceControls[sounds[i].voice];
+        sounds[i].event.audioProducer->setPitch(control.pitch);
+        sounds[i].event.audioProducer->addOntoSamples(scratch, nbSamples, control.volume);
+    }
+}
+
+void AudioStream::i_advanceTimeline()
+{
+    m_bufferSample += m_samplesPerBuffer;
+
+    //Rendering should run one compensation delay behind the wall clock. Small errors are slewed
+    //out of the epoch; a stall jumps the sample counter so voices are kept rather than dropped.
+    const double error = getTime() - m_compensationDelay - sampleToTime(m_bufferSample);
+    if(error > m_compensationDelay * 3.0)
+    {
+        m_nbResyncs++;
+        m_bufferSample += llround(error * m_sampleRate);
+    }
+    else
+    {
+        m_timelineEpoch.store(m_timelineEpoch.load(std::memory_order_relaxed) + error * CLOCK_SLEW, std::memory_order_relaxed);
+    }
+}
+
+void AudioStream::i_renderBlock(int16_t* output)
+{
+    const size_t nbSamples = m_samplesPerBuffer;
+    memset(m_workBuffer, 0, nbSamples * sizeof(float));
+
+    i_drainCommandQueue();
+
+    i_mixActiveSounds(nbSamples);
+    i_mixFadingSounds(nbSamples);
+    i_startPendingSounds();
+    i_removeExpiredSounds();
+
+    m_masterBus.process(m_workBuffer, output, nbSamples);
+
+    m_nbActiveVoices.store(m_activeSounds.size(), std::memory_order_relaxed);
+    m_nbPendingVoices.store(m_pendingSounds.size(), std::memory_order_relaxed);
+}
+
+bool AudioStream::i_renderNextBuffer()
+{
+    ENGMSC_RT_SCOPE("AudioStream::i_renderNextBuffer");
+    ENGMSC_TRACE_SCOPE("AudioStream::renderBlock");
+
+    Buffer* buffer;
+    if(!m_freeBuffers.tryPop(buffer)) return false;
+
+    const MainClock::time_point renderStart = MainClock::now();
+    i_renderBlock(buffer->data);
+    i_advanceTimeline();
+    m_renderTimes.record(std::chrono::duration_cast<std::chrono::nanoseconds>(MainClock::now() - renderStart).count());
+
+    m_readyBuffers.tryPush(buffer);
+    return true;
+}
+
+void AudioStream::i_releaseHeldBuffer()
+{
+    if(!m_heldBuffer) return;
+
+    m_freeBuffers.tryPush(m_heldBuffer);
+    m_heldBuffer = nullptr;
+
+    if(isRenderThreadRunning()) m_renderCV.notify_one();
+}
+
+void AudioStream::i_renderThread()
+{
+    const std::chrono::duration<double> pollInterval(m_bufferDuration / 4.0);
+    Tracer::registerThread("AudioStream render");
+
+    const RealtimeReport report = RealtimeMode::applyToCurrentThread(m_realtimeOptions, m_realtimeOptions.cpu);
+    {
+        std::unique_lock<std::mutex> lock(m_realtimeReportMutex);
+        m_renderRealtimeReport = report;
+    }
+
+    while(m_renderThreadRunning.load(std::memory_order_acquire))
+    {
+        //One block per iteration keeps the cost per buffer flat instead of refilling the pool in a burst
+        if(i_renderNextBuffer()) continue;
+
+        //The consumer notifies without taking the mutex, so the timed wait bounds a missed wake-up
+        std::unique_lock<std::mutex> lock(m_renderMutex);
+        m_renderCV.wait_for(lock, pollInterval);
+    }
+}
+
+void AudioStream::startRenderThread()
+{
+    std::unique_lock<std::mutex> lock(m_renderControlMutex);
+    if(isRenderThreadRunning()) return;
+
+    i_pauseRendering();
+    i_resumeRendering(RENDER_THREAD);
+}
+
+void AudioStream::stopRenderThread()
+{
+    std::unique_lock<std::mutex> lock(m_renderControlMutex);
+    if(!isRenderThreadRunning()) return;
+
+    i_pauseRendering();
+    i_resumeRendering(RENDER_INLINE);
+}
+
+bool AudioStream::isRenderThreadRunning() const
+{
+    return m_renderMode.load(std::memory_order_acquire) == RENDER_THREAD;
+}
+
+void AudioStream::i_setRenderMode(RenderMode mode)
+{
+    //Pairs with the store and load at the top of tryGetNextBuffer()
+    m_renderMode.store(mode, std::memory_order_seq_cst);
+    while(m_consumerActive.load(std::memory_order_seq_cst))
+    {
+        std::this_thread::yield();
+    }
+}
+
+AudioStream::RenderMode AudioStream::i_pauseRendering()
+{
+    //Nobody renders once this returns: the consumer is out and the render thread joined
+    const RenderMode mode = RenderMode(m_renderMode.load(std::memory_order_relaxed));
+    i_setRenderMode(RENDER_PAUSED);
+
+    if(m_renderThread)
+    {
         {
-            float sample = highPass.filter(m_workBuffer[i]);
-            sample = sample * 0.5f + lowPass.filter(sample);
-            sample = std::max(-1.0f, std::min(sample, 1.0f));
-            currentBuffer.data[i] = S(sample) * 32760;
+            std::unique_lock<std::mutex> lock(m_renderMutex);
+            m_renderThreadRunning = false;
         }
-        m_outputBufferQueue.push(&currentBuffer);
-        m_inputBufferQueue.pop();
-        m_bufferTime += BUFFER_DURATION;
+        m_renderCV.notify_all();
+
+        m_renderThread->join();
+        delete m_renderThread;
+        m_renderThread = nullptr;
+    }
+    return mode;
+}
+
+void AudioStream::i_resumeRendering(RenderMode mode)
+{
+    if(mode == RENDER_THREAD)
+    {
+        m_renderThreadRunning = true;
+        m_renderThread = new std::thread(&AudioStream::i_renderThread, this);
     }
+    i_setRenderMode(mode);
+}
+
+void AudioStream::setMixThreads(size_t nbThreads)
+{
+    //The renderer uses the pool every block, whether it runs inline or on its own thread
+    std::unique_lock<std::mutex> lock(m_renderControlMutex);
+    const RenderMode mode = i_pauseRendering();
+    i_setMixThreads(nbThreads);
+    i_resumeRendering(mode);
+}
+
+void AudioStream::i_setMixThreads(size_t nbThreads)
+{
+    //Mix workers take the CPUs after the render thread's
+    RealtimeOptions mixOptions = m_realtimeOptions;
+    if(mixOptions.cpu >= 0) mixOptions.cpu++;
+
+    delete m_mixThreadPool;
+    m_mixThreadPool = nbThreads > 1 ? new MixThreadPool(nbThreads - 1, m_samplesPerBuffer, mixOptions) : nullptr;
+}
+
+size_t AudioStream::getMixThreads() const
+{
+    return m_mixThreadPool ? m_mixThreadPool->getNbWorkers() + 1 : 1;
+}
+
+void AudioStream::setRealtimeOptions(const RealtimeOptions& options)
+{
+    //Threads read the options when they start, so the running ones are restarted
+    std::unique_lock<std::mutex> lock(m_renderControlMutex);
+    const RenderMode mode = i_pauseRendering();
+
+    //Unlock whatever the previous options locked, including a partially successful attempt
+    if(m_realtimeOptions.enabled && m_realtimeOptions.lockMemory) i_lockMemory(false);
+    m_realtimeOptions = options;
+    m_memoryLocked = options.enabled && options.lockMemory && i_lockMemory(true);
+    {
+        std::unique_lock<std::mutex> reportLock(m_realtimeReportMutex);
+        m_renderRealtimeReport = RealtimeReport();
+    }
+
+    if(m_mixThreadPool) i_setMixThreads(getMixThreads());
+    i_resumeRendering(mode);
+}
+
+RealtimeReport AudioStream::getRealtimeReport()
+{
+    RealtimeReport report;
+    {
+        std::unique_lock<std::mutex> lock(m_realtimeReportMutex);
+        report = m_renderRealtimeReport;
+    }
+    report.memoryLocked = m_memoryLocked;
+
+    if(m_mixThreadPool) report = RealtimeMode::combine(report, m_mixThreadPool->getRealtimeReport());
+    return report;
+}
+
+bool AudioStream::i_lockMemory(bool lock)
+{
+    //Everything the render path touches per block; the vectors are reserved up front and never grow
+    struct Region
+    {
+        const void* data;
+        size_t size;
+    };
+    const Region regions[] =
+    {
+        {m_bufferPoolData, m_samplesPerBuffer * m_bufferPoolSize * sizeof(int16_t)},
+        {m_workBuffer, m_samplesPerBuffer * sizeof(float)},
+        {m_fadeBuffer, m_fadeSamples * sizeof(float)},
+        {m_pendingSounds.data(), m_pendingSounds.capacity() * sizeof(TimedSoundEvent)},
+        {m_activeSounds.data(), m_activeSounds.capacity() * sizeof(TimedSoundEvent)},
+        {m_fadingSounds.data(), m_fadingSounds.capacity() * sizeof(TimedSoundEvent)},
+        {m_voiceControls.data(), m_voiceControls.size() * sizeof(VoiceControl)},
+        {m_voiceGenerations.get(), MAX_VOICES * sizeof(std::atomic<uint32_t>)}
+    };
+
+    bool locked = true;
+    for(const Region& region : regions)
+    {
+        if(lock) locked = RealtimeMode::lockMemory(region.data, region.size) && locked;
+        else RealtimeMode::unlockMemory(region.data, region.size);
+    }
+    return locked;
 }
 
 void AudioStream::resartStream()
 {
-    m_timeStreamStarted = MainClock::now().time_since_epoch().count();
-    m_bufferTime = -COMPENSAION_DELAY;
+    //The held and ready buffers belong to the consumer, which stays out while rendering is paused
+    std::unique_lock<std::mutex> lock(m_renderControlMutex);
+    const RenderMode mode = i_pauseRendering();
+    i_releaseHeldBuffer();
 
-    while(m_outputBufferQueue.size() > 0)
+    m_timeStreamStarted = MainClock::now();
+    m_timelineEpoch = -m_compensationDelay;
+    m_bufferSample = 0;
+
+    Buffer* buffer;
+    while(m_readyBuffers.tryPop(buffer))
     {
-        m_inputBufferQueue.push(m_outputBufferQueue.front());
-        m_outputBufferQueue.pop();
+        m_freeBuffers.tryPush(buffer);
     }
+
+    i_resumeRendering(mode);
 }
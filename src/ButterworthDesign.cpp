@@ -0,0 +1,149 @@
+#include <engmsc/ButterworthDesign.hpp>
+
+#include <algorithm>
+#include <complex>
+#include <math.h>
+
+typedef std::complex<double> Complex;
+
+//Edges are kept just inside (0, Nyquist), where tan() stays finite
+static const double MIN_EDGE = 1e-8;
+
+static double prewarp(double frequency, double sampleRate)
+{
+    const double omega = M_PI * frequency / sampleRate;
+    return tan(std::max(MIN_EDGE, std::min(omega, M_PI / 2.0 - MIN_EDGE)));
+}
+
+//Poles of the normalized analog prototype in the upper half plane, then the real one for odd orders
+static Complex prototypePole(size_t order, size_t index)
+{
+    const double angle = M_PI * double(2 * index + order + 1) / double(2 * order);
+    return std::polar(1.0, angle);
+}
+
+static Complex bilinear(Complex s)
+{
+    return (1.0 + s) / (1.0 - s);
+}
+
+size_t ButterworthDesign::lowPass(size_t order, double sampleRate, double cutoff, BiquadCoefficients* sections)
+{
+    return i_lowOrHighPass(order, sampleRate, cutoff, false, sections);
+}
+
+size_t ButterworthDesign::highPass(size_t order, double sampleRate, double cutoff, BiquadCoefficients* sections)
+{
+    return i_lowOrHighPass(order, sampleRate, cutoff, true, sections);
+}
+
+size_t ButterworthDesign::bandPass(size_t order, double sampleRate, double centerFrequency, double widthFrequency, BiquadCoefficients* sections)
+{
+    order = std::max<size_t>(1, std::min(order, MAX_ORDER));
+    const double lowEdge = prewarp(centerFrequency - widthFrequency / 2.0, sampleRate);
+    const double highEdge = prewarp(centerFrequency + widthFrequency / 2.0, sampleRate);
+    const double width = std::max(highEdge - lowEdge, MIN_EDGE);
+    const double center2 = lowEdge * highEdge;
+
+    //s -> (s^2 + center^2) / (s width): every prototype pole p becomes the roots of s^2 - p width s + center^2
+    size_t nbSections = 0;
+    for(size_t k = 0; k < (order + 1) / 2; k++)
+    {
+        const Complex p = prototypePole(order, k);
+        const Complex root = std::sqrt(p * p * width * width - 4.0 * center2);
+        const Complex s1 = (p * width + root) / 2.0;
+        const Complex s2 = (p * width - root) / 2.0;
+
+        if(2 * k + 1 == order)
+        {
+            //The real prototype pole gives a conjugate pair or two real poles: one section either way
+            const Complex z1 = bilinear(s1);
+            const Complex z2 = bilinear(s2);
+            sections[nbSections].a1 = -(z1 + z2).real();
+            sections[nbSections].a2 = (z1 * z2).real();
+            nbSections++;
+        }
+        else
+        {
+            //Each root pairs with its conjugate, which comes from the conjugate prototype pole
+            for(const Complex& s : { s1, s2 })
+            {
+                const Complex z = bilinear(s);
+                sections[nbSections].a1 = -2.0 * z.real();
+                sections[nbSections].a2 = std::norm(z);
+                nbSections++;
+            }
+        }
+    }
+
+    //Zeros at DC and Nyquist for every section; unity gain at the geometric band center
+    const Complex zCenter = std::polar(1.0, 2.0 * atan(sqrt(center2)));
+    const Complex zInv = 1.0 / zCenter;
+    double gain = 1.0;
+    for(size_t i = 0; i < nbSections; i++)
+    {
+        const Complex numerator = 1.0 - zInv * zInv;
+        const Complex denominator = 1.0 + sections[i].a1 * zInv + sections[i].a2 * zInv * zInv;
+        gain *= std::abs(numerator / denominator);
+    }
+
+    const double sectionGain = pow(gain, -1.0 / double(nbSections));
+    for(size_t i = 0; i < nbSections; i++)
+    {
+        sections[i].b0 = sectionGain;
+        sections[i].b1 = 0.0;
+        sections[i].b2 = -sectionGain;
+    }
+    return nbSections;
+}
+
+size_t ButterworthDesign::getNbSections(size_t order)
+{
+    return (std::max<size_t>(1, std::min(order, MAX_ORDER)) + 1) / 2;
+}
+
+size_t ButterworthDesign::getNbBandPassSections(size_t order)
+{
+    return std::max<size_t>(1, std::min(order, MAX_ORDER));
+}
+
+size_t ButterworthDesign::i_lowOrHighPass(size_t order, double sampleRate, double cutoff, bool highPass, BiquadCoefficients* sections)
+{
+    order = std::max<size_t>(1, std::min(order, MAX_ORDER));
+    const double k = prewarp(cutoff, sampleRate);
+
+    //s -> k / s maps the Butterworth poles onto themselves, so high and low pass differ only in their zeros
+    size_t nbSections = 0;
+    for(size_t i = 0; i < (order + 1) / 2; i++)
+    {
+        BiquadCoefficients& section = sections[nbSections++];
+        const Complex p = prototypePole(order, i) * k;
+
+        if(2 * i + 1 == order)
+        {
+            const double z = bilinear(p).real();
+            section.a1 = -z;
+            section.a2 = 0.0;
+
+            //(1 + z^-1) or (1 - z^-1), scaled to unity gain at DC or Nyquist; (1 - z) / 2 and
+            //(1 + z) / 2 are taken from p, as they cancel for poles near z = 1
+            const double gain = highPass ? 1.0 / (1.0 - p.real()) : -p.real() / (1.0 - p.real());
+            section.b0 = gain;
+            section.b1 = highPass ? -gain : gain;
+            section.b2 = 0.0;
+        }
+        else
+        {
+            const Complex z = bilinear(p);
+            section.a1 = -2.0 * z.real();
+            section.a2 = std::norm(z);
+
+            //|1 + z|^2 / 4 or |1 - z|^2 / 4 from p directly: 1 + a1 + a2 cancels at low cutoffs
+            const double gain = highPass ? 1.0 / std::norm(1.0 - p) : std::norm(p) / std::norm(1.0 - p);
+            section.b0 = gain;
+            section.b1 = highPass ? -2.0 * gain : 2.0 * gain;
+            section.b2 = gain;
+        }
+    }
+    return nbSections;
+}
@@ -0,0 +1,52 @@
+#include <engmsc/CachedKickProducer.hpp>
+#include <algorithm>
+#include <cstring>
+
+CachedKickProducer::CachedKickProducer(KickCache::Table* table) :
+    m_table(table)
+{
+    m_table->retain();
+}
+
+size_t CachedKickProducer::produceSamples(float* buffer, size_t bufferSize)
+{
+    const size_t nbSamples = std::min(bufferSize, m_table->getNbSamples() - m_samplePos);
+    memcpy(buffer, m_table->getSamples() + m_samplePos, nbSamples * sizeof(float));
+    std::fill(buffer + nbSamples, buffer + bufferSize, 0.0f);
+    m_samplePos += nbSamples;
+
+    return nbSamples;
+}
+
+size_t CachedKickProducer::addOntoSamples(float* buffer, size_t bufferSize, float gain)
+{
+    const size_t nbSamples = std::min(bufferSize, m_table->getNbSamples() - m_samplePos);
+    const float* samples = m_table->getSamples() + m_samplePos;
+    for(size_t i = 0; i < nbSamples; i++)
+    {
+        buffer[i] += samples[i] * gain;
+    }
+    m_samplePos += nbSamples;
+
+    return nbSamples;
+}
+
+double CachedKickProducer::getDuration() const
+{
+    return double(m_table->getNbSamples()) / m_sampleRate;
+}
+
+bool CachedKickProducer::hasExpired() const
+{
+    return m_samplePos >= m_table->getNbSamples();
+}
+
+float CachedKickProducer::getPeakLevel() const
+{
+    return m_table->getPeakFrom(m_samplePos);
+}
+
+CachedKickProducer::~CachedKickProducer()
+{
+    m_table->release();
+}
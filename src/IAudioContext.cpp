@@ -3,4 +3,9 @@
 IAudioContext::IAudioContext()
 {
     
+}
+
+void IAudioContext::reportUnderrun(AudioStream& audioStream)
+{
+    audioStream.m_nbUnderruns.fetch_add(1, std::memory_order_relaxed);
 }
\ No newline at end of file
@@ -1,10 +1,60 @@
 #include <engmsc/IAudioProducer.hpp>
+#include <engmsc/VoicePool.hpp>
 
 IAudioProducer::IAudioProducer()
 {
     
 }
 
+void IAudioProducer::setPitch(float)
+{
+    
+}
+
+float IAudioProducer::getPeakLevel() const
+{
+    return 1.0f;
+}
+
+void IAudioProducer::setLowDetail(bool)
+{
+    
+}
+
+void IAudioProducer::setParameter(int, float)
+{
+    
+}
+
+void IAudioProducer::setSampleRate(unsigned sampleRate)
+{
+    m_sampleRate = sampleRate;
+}
+
+unsigned IAudioProducer::getSampleRate() const
+{
+    return m_sampleRate;
+}
+
+void IAudioProducer::dispose(IAudioProducer* producer)
+{
+    if(!producer) return;
+
+    if(producer->m_voicePool)
+    {
+        producer->m_voicePool->recycle(producer);
+    }
+    else
+    {
+        delete producer;
+    }
+}
+
+IVoicePool* IAudioProducer::getVoicePool() const
+{
+    return m_voicePool;
+}
+
 IAudioProducer::~IAudioProducer()
 {
     
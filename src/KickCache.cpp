@@ -0,0 +1,204 @@
+#include <engmsc/KickCache.hpp>
+#include <engmsc/CachedKickProducer.hpp>
+#include <engmsc/AudioStream.hpp>
+#include <engmsc/KickProducer.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <math.h>
+
+const float* KickCache::Table::getSamples() const
+{
+    return m_samples;
+}
+
+size_t KickCache::Table::getNbSamples() const
+{
+    return m_nbSamples;
+}
+
+float KickCache::Table::getPeakFrom(size_t sample) const
+{
+    if(sample >= m_nbSamples) return 0.0f;
+    return m_peaks[sample / PEAK_BLOCK_SIZE];
+}
+
+void KickCache::Table::retain()
+{
+    m_refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void KickCache::Table::release()
+{
+    if(m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+}
+
+KickCache::Table::Table(size_t nbSamples) :
+    m_samples(new float[nbSamples]),
+    m_nbSamples(nbSamples),
+    m_peaks(new float[nbSamples / PEAK_BLOCK_SIZE + 1]) {}
+
+KickCache::Table::~Table()
+{
+    delete[] m_samples;
+    delete[] m_peaks;
+}
+
+size_t KickCache::Table::i_memoryUsage() const
+{
+    return sizeof(Table) + (m_nbSamples + m_nbSamples / PEAK_BLOCK_SIZE + 1) * sizeof(float);
+}
+
+bool KickCache::Key::operator==(const Key& key) const
+{
+    return factor == key.factor && factor2 == key.factor2 && duration == key.duration;
+}
+
+size_t KickCache::KeyHash::operator()(const Key& key) const
+{
+    uint64_t hash = uint32_t(key.factor);
+    hash = hash * 0x9E3779B97F4A7C15ull + uint32_t(key.factor2);
+    hash = hash * 0x9E3779B97F4A7C15ull + uint32_t(key.duration);
+    return size_t(hash ^ (hash >> 29));
+}
+
+KickCache::KickCache(unsigned sampleRate, size_t memoryLimit) :
+    m_sampleRate(sampleRate),
+    m_memoryLimit(memoryLimit) {}
+
+KickCache::Table* KickCache::getTable(float factor, float factor2, float duration)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    const Key key = { int32_t(lroundf(factor / m_factorStep)), int32_t(lroundf(factor2 / m_factor2Step)), int32_t(lroundf(duration / m_durationStep)) };
+
+    auto found = m_tables.find(key);
+    if(found != m_tables.end())
+    {
+        m_nbHits++;
+        m_lru.splice(m_lru.begin(), m_lru, found->second);
+        Table* table = found->second->second;
+        table->retain();
+        return table;
+    }
+
+    m_nbMisses++;
+    Table* table = i_render(key);
+    const size_t usage = table->i_memoryUsage();
+
+    //The new table always goes in, even on its own over the limit; older ones make room
+    m_nbEvictions += i_evict(m_memoryLimit > usage ? m_memoryLimit - usage : 0);
+    m_lru.emplace_front(key, table);
+    m_tables[key] = m_lru.begin();
+    m_memoryUsage += usage;
+
+    table->retain();
+    return table;
+}
+
+CachedKickProducer* KickCache::newProducer(AudioStream& stream, float factor, float factor2, float duration)
+{
+    //Tables play back sample for sample, so another rate would shift the kick's pitch and length
+    assert(stream.getSampleRate() == m_sampleRate && "KickCache and AudioStream sample rates differ");
+    if(stream.getSampleRate() != m_sampleRate) return nullptr;
+
+    Table* table = getTable(factor, factor2, duration);
+    CachedKickProducer* producer = stream.newProducer<CachedKickProducer>(table);
+    table->release();
+    return producer;
+}
+
+void KickCache::setQuantization(float factorStep, float factor2Step, float durationStep)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    i_evict(0);
+    m_factorStep = factorStep;
+    m_factor2Step = factor2Step;
+    m_durationStep = durationStep;
+}
+
+void KickCache::setMemoryLimit(size_t bytes)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_memoryLimit = bytes;
+    m_nbEvictions += i_evict(m_memoryLimit);
+}
+
+size_t KickCache::getMemoryLimit() const
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_memoryLimit;
+}
+
+unsigned KickCache::getSampleRate() const
+{
+    return m_sampleRate;
+}
+
+void KickCache::clear()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    i_evict(0);
+}
+
+KickCacheStats KickCache::getStats() const
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    KickCacheStats stats;
+    stats.hits = m_nbHits;
+    stats.misses = m_nbMisses;
+    stats.evictions = m_nbEvictions;
+    stats.nbTables = m_lru.size();
+    stats.memoryUsage = m_memoryUsage;
+    stats.memoryLimit = m_memoryLimit;
+    return stats;
+}
+
+void KickCache::resetStats()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_nbHits = 0;
+    m_nbMisses = 0;
+    m_nbEvictions = 0;
+}
+
+KickCache::~KickCache()
+{
+    clear();
+}
+
+KickCache::Table* KickCache::i_render(const Key& key) const
+{
+    KickProducer kick(key.factor * m_factorStep, key.factor2 * m_factor2Step, key.duration * m_durationStep);
+    kick.setSampleRate(m_sampleRate);
+    //Each key gets its own noise, and the same noise every time it is rendered again
+    kick.setNoiseSeed(uint32_t(KeyHash()(key)) | 1u);
+
+    Table* table = new Table(size_t(ceil(kick.getDuration() * m_sampleRate)));
+    table->m_nbSamples = kick.produceSamples(table->m_samples, table->m_nbSamples);
+
+    //Running maximum from the end, kept per block for getPeakFrom
+    float peak = 0.0f;
+    for(size_t i = table->m_nbSamples; i > 0; i--)
+    {
+        peak = std::max(peak, fabsf(table->m_samples[i - 1]));
+        if((i - 1) % Table::PEAK_BLOCK_SIZE == 0) table->m_peaks[(i - 1) / Table::PEAK_BLOCK_SIZE] = peak;
+    }
+
+    return table;
+}
+
+size_t KickCache::i_evict(size_t limit)
+{
+    size_t nbEvicted = 0;
+    //Tables still referenced by playing voices are freed by their last release
+    while(m_memoryUsage > limit && !m_lru.empty())
+    {
+        Table* table = m_lru.back().second;
+        m_memoryUsage -= table->i_memoryUsage();
+        m_tables.erase(m_lru.back().first);
+        m_lru.pop_back();
+        nbEvicted++;
+        table->release();
+    }
+    return nbEvicted;
+}
@@ -0,0 +1,83 @@
+#include <engmsc/MasterBus.hpp>
+#include <engmsc/simd/OutputStage.hpp>
+
+#include <algorithm>
+
+static const size_t FILTER_ORDER = 4;
+//The mix is filtered in double precision chunks of this many samples on the stack
+static const size_t FILTER_CHUNK_SIZE = 256;
+static const size_t HIGH_PASS_LANE = 0;
+static const size_t LOW_PASS_LANE = 1;
+
+MasterBus::MasterBus(unsigned sampleRate) :
+    m_sampleRate(sampleRate) {}
+
+void MasterBus::setHighPassCutoff(double cutoff)
+{
+    m_highPassCutoff.store(cutoff, std::memory_order_relaxed);
+    m_coefficientsDirty.store(true, std::memory_order_release);
+}
+
+void MasterBus::setLowPassCutoff(double cutoff)
+{
+    m_lowPassCutoff.store(cutoff, std::memory_order_relaxed);
+    m_coefficientsDirty.store(true, std::memory_order_release);
+}
+
+void MasterBus::setDryGain(float dryGain)
+{
+    m_dryGain.store(dryGain, std::memory_order_relaxed);
+}
+
+double MasterBus::getHighPassCutoff() const
+{
+    return m_highPassCutoff.load(std::memory_order_relaxed);
+}
+
+double MasterBus::getLowPassCutoff() const
+{
+    return m_lowPassCutoff.load(std::memory_order_relaxed);
+}
+
+float MasterBus::getDryGain() const
+{
+    return m_dryGain.load(std::memory_order_relaxed);
+}
+
+void MasterBus::process(float* mix, int16_t* output, size_t nbSamples)
+{
+    if(m_coefficientsDirty.exchange(false, std::memory_order_acquire))
+    {
+        i_updateCoefficients();
+    }
+
+    //Lane 0 is the high-passed mix and lane 1 the high-passed mix through the low pass, so both
+    //filters advance together in one two-lane cascade
+    const double dryGain = m_dryGain.load(std::memory_order_relaxed);
+    double filtered[FILTER_CHUNK_SIZE * 2];
+    for(size_t chunk = 0; chunk < nbSamples; chunk += FILTER_CHUNK_SIZE)
+    {
+        const size_t chunkSize = std::min(FILTER_CHUNK_SIZE, nbSamples - chunk);
+        for(size_t i = 0; i < chunkSize; i++)
+        {
+            filtered[i * 2] = mix[chunk + i];
+            filtered[i * 2 + 1] = mix[chunk + i];
+        }
+        m_filters.process(filtered, chunkSize);
+
+        for(size_t i = 0; i < chunkSize; i++)
+        {
+            mix[chunk + i] = float(filtered[i * 2] * dryGain + filtered[i * 2 + 1]);
+        }
+    }
+    OutputStage::process(mix, output, nbSamples);
+}
+
+void MasterBus::i_updateCoefficients()
+{
+    BiquadCoefficients sections[ButterworthDesign::MAX_ORDER * 2];
+    const size_t nbHighPassSections = ButterworthDesign::highPass(FILTER_ORDER, m_sampleRate, m_highPassCutoff.load(std::memory_order_relaxed), sections);
+    m_filters.setup(HIGH_PASS_LANE, sections, nbHighPassSections);
+    const size_t nbLowPassSections = ButterworthDesign::lowPass(FILTER_ORDER, m_sampleRate, m_lowPassCutoff.load(std::memory_order_relaxed), sections + nbHighPassSections);
+    m_filters.setup(LOW_PASS_LANE, sections, nbHighPassSections + nbLowPassSections);
+}
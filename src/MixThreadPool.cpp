@@ -0,0 +1,201 @@
+#include <engmsc/MixThreadPool.hpp>
+#include <engmsc/simd/SimdSupport.hpp>
+#include <engmsc/debug/RealtimeChecker.hpp>
+#include <engmsc/debug/Tracer.hpp>
+
+#include <cstring>
+
+#ifdef ENGMSC_SIMD_SSE2
+    #include <emmintrin.h>
+#endif
+
+//Workers spin this many times on a new generation before falling back to the condition variable
+static const int WORKER_SPIN_COUNT = 2000;
+
+//Scratch buffers are padded to a whole number of cache lines to keep workers off each other's lines
+static const size_t SCRATCH_PADDING = 16;
+
+static void addSamples(float* destination, const float* source, size_t nbSamples)
+{
+    size_t i = 0;
+#ifdef ENGMSC_SIMD_SSE2
+    for(; i + 4 <= nbSamples; i += 4)
+    {
+        _mm_storeu_ps(destination + i, _mm_add_ps(_mm_loadu_ps(destination + i), _mm_loadu_ps(source + i)));
+    }
+#endif
+    for(; i < nbSamples; i++)
+    {
+        destination[i] += source[i];
+    }
+}
+
+MixThreadPool::MixThreadPool(size_t nbWorkers, size_t maxSamples, const RealtimeOptions& realtimeOptions) :
+    m_maxSamples((maxSamples + SCRATCH_PADDING - 1) / SCRATCH_PADDING * SCRATCH_PADDING),
+    m_realtimeOptions(realtimeOptions),
+    m_participants(nbWorkers + 1),
+    m_scratchData(new float[m_maxSamples * (nbWorkers + 1)])
+{
+    m_reduceList.reserve(m_participants.size());
+    for(size_t i = 0; i < m_participants.size(); i++)
+    {
+        m_participants[i].scratch = m_scratchData + m_maxSamples * i;
+    }
+
+    if(m_realtimeOptions.enabled && m_realtimeOptions.lockMemory)
+    {
+        m_memoryLocked = RealtimeMode::lockMemory(m_scratchData, m_maxSamples * m_participants.size() * sizeof(float));
+    }
+
+    //Participant 0 is whichever thread calls run()
+    for(size_t i = 1; i < m_participants.size(); i++)
+    {
+        m_workers.push_back(new std::thread(&MixThreadPool::i_workerThread, this, i));
+    }
+}
+
+void MixThreadPool::run(Job job, void* context, size_t nbJobs, float* output, size_t nbSamples)
+{
+    if(nbJobs == 0) return;
+
+    m_job = job;
+    m_jobContext = context;
+    m_nbJobs = nbJobs;
+    m_nbSamples = nbSamples;
+    m_nextJob.store(0, std::memory_order_relaxed);
+    m_workersBusy.store(m_workers.size(), std::memory_order_relaxed);
+
+    //Sequentially consistent with the parked count: either a parking worker sees the new
+    //generation, or it is counted here and the lock below orders the notify after its wait
+    m_generation.fetch_add(1, std::memory_order_seq_cst);
+    if(m_nbParked.load(std::memory_order_seq_cst) > 0)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_wakeMutex);
+        }
+        m_wakeCV.notify_all();
+    }
+
+    i_runJobs(m_participants[0]);
+    while(m_workersBusy.load(std::memory_order_acquire) > 0)
+    {
+        std::this_thread::yield();
+    }
+
+    i_reduce(output);
+}
+
+size_t MixThreadPool::getNbWorkers() const
+{
+    return m_workers.size();
+}
+
+RealtimeReport MixThreadPool::getRealtimeReport()
+{
+    std::unique_lock<std::mutex> lock(m_reportMutex);
+    RealtimeReport report = m_realtimeReport;
+    report.applied = report.applied && m_nbReports == m_workers.size();
+    report.memoryLocked = m_memoryLocked;
+    return report;
+}
+
+MixThreadPool::~MixThreadPool()
+{
+    m_running.store(false, std::memory_order_release);
+    {
+        std::unique_lock<std::mutex> lock(m_wakeMutex);
+        m_generation.fetch_add(1, std::memory_order_seq_cst);
+    }
+    m_wakeCV.notify_all();
+
+    for(std::thread* worker : m_workers)
+    {
+        worker->join();
+        delete worker;
+    }
+
+    if(m_realtimeOptions.enabled && m_realtimeOptions.lockMemory)
+    {
+        RealtimeMode::unlockMemory(m_scratchData, m_maxSamples * m_participants.size() * sizeof(float));
+    }
+    delete[] m_scratchData;
+}
+
+void MixThreadPool::i_workerThread(size_t participant)
+{
+    Tracer::registerThread("Mix worker");
+
+    const int cpu = m_realtimeOptions.cpu >= 0 ? m_realtimeOptions.cpu + int(participant) - 1 : -1;
+    const RealtimeReport report = RealtimeMode::applyToCurrentThread(m_realtimeOptions, cpu);
+    {
+        std::unique_lock<std::mutex> lock(m_reportMutex);
+        m_realtimeReport = m_nbReports++ ? RealtimeMode::combine(m_realtimeReport, report) : report;
+    }
+
+    size_t seenGeneration = 0;
+    for(;;)
+    {
+        size_t generation = m_generation.load(std::memory_order_acquire);
+        for(int spin = 0; generation == seenGeneration && spin < WORKER_SPIN_COUNT; spin++)
+        {
+            std::this_thread::yield();
+            generation = m_generation.load(std::memory_order_acquire);
+        }
+        if(generation == seenGeneration)
+        {
+            std::unique_lock<std::mutex> lock(m_wakeMutex);
+            m_nbParked.fetch_add(1, std::memory_order_seq_cst);
+            m_wakeCV.wait(lock, [&]() { return m_generation.load(std::memory_order_seq_cst) != seenGeneration; });
+            m_nbParked.fetch_sub(1, std::memory_order_relaxed);
+            generation = m_generation.load(std::memory_order_acquire);
+        }
+        seenGeneration = generation;
+
+        //Stored before the generation bump that woke us, so the acquire above makes it visible
+        if(!m_running.load(std::memory_order_acquire)) return;
+
+        i_runJobs(m_participants[participant]);
+        m_workersBusy.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+void MixThreadPool::i_runJobs(Participant& participant)
+{
+    ENGMSC_RT_SCOPE("MixThreadPool::i_runJobs");
+
+    participant.used = false;
+
+    size_t jobIndex;
+    while((jobIndex = m_nextJob.fetch_add(1, std::memory_order_relaxed)) < m_nbJobs)
+    {
+        if(!participant.used)
+        {
+            memset(participant.scratch, 0, m_nbSamples * sizeof(float));
+            participant.used = true;
+        }
+        m_job(m_jobContext, jobIndex, participant.scratch, m_nbSamples);
+    }
+}
+
+void MixThreadPool::i_reduce(float* output)
+{
+    m_reduceList.clear();
+    for(Participant& participant : m_participants)
+    {
+        if(participant.used) m_reduceList.push_back(participant.scratch);
+    }
+
+    //Pairwise sums keep the dependency chain log2(participants) deep
+    for(size_t stride = 1; stride < m_reduceList.size(); stride *= 2)
+    {
+        for(size_t i = 0; i + stride < m_reduceList.size(); i += stride * 2)
+        {
+            addSamples(m_reduceList[i], m_reduceList[i + stride], m_nbSamples);
+        }
+    }
+
+    if(!m_reduceList.empty())
+    {
+        addSamples(output, m_reduceList[0], m_nbSamples);
+    }
+}
@@ -0,0 +1,136 @@
+#include <engmsc/NoiseSource.hpp>
+#include <engmsc/simd/SimdSupport.hpp>
+
+#include <atomic>
+#include <cstring>
+
+#ifdef ENGMSC_SIMD_SSE2
+    #include <emmintrin.h>
+#endif
+
+//sqrt(3/4): a uniform on [-1, 1) has variance 1/3, four of them summed have 4/3
+static const float GAUSSIAN_SCALE = 0.8660254f;
+
+static std::atomic<uint32_t> nextAutoSeed{0x9E3779B9u};
+
+static uint32_t splitMix32(uint32_t x)
+{
+    x += 0x9E3779B9u;
+    x = (x ^ (x >> 16)) * 0x85EBCA6Bu;
+    x = (x ^ (x >> 13)) * 0xC2B2AE35u;
+    return x ^ (x >> 16);
+}
+
+//Top 23 bits as the mantissa of a float in [2, 4), shifted down to [-1, 1)
+static inline float bitsToUniform(uint32_t bits)
+{
+    const uint32_t floatBits = (bits >> 9) | 0x40000000u;
+    float value;
+    memcpy(&value, &floatBits, sizeof(value));
+    return value - 3.0f;
+}
+
+#ifdef ENGMSC_SIMD_SSE2
+static inline __m128i xorshiftStep(__m128i& state)
+{
+    __m128i x = state;
+    x = _mm_xor_si128(x, _mm_slli_epi32(x, 13));
+    x = _mm_xor_si128(x, _mm_srli_epi32(x, 17));
+    x = _mm_xor_si128(x, _mm_slli_epi32(x, 5));
+    state = x;
+    return x;
+}
+
+static inline __m128 bitsToUniform(__m128i bits)
+{
+    const __m128i floatBits = _mm_or_si128(_mm_srli_epi32(bits, 9), _mm_set1_epi32(0x40000000));
+    return _mm_sub_ps(_mm_castsi128_ps(floatBits), _mm_set1_ps(3.0f));
+}
+#endif
+
+NoiseSource::NoiseSource(uint32_t seed)
+{
+    setSeed(seed ? seed : nextAutoSeed.fetch_add(0x6D2B79F5u, std::memory_order_relaxed));
+}
+
+void NoiseSource::setSeed(uint32_t seed)
+{
+    for(unsigned lane = 0; lane < 4; lane++)
+    {
+        //xorshift never leaves the all-zero state
+        m_state[lane] = splitMix32(seed * 4u + lane);
+        if(!m_state[lane]) m_state[lane] = 1;
+    }
+    m_lane = 0;
+}
+
+inline uint32_t NoiseSource::i_nextBits()
+{
+    uint32_t x = m_state[m_lane];
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    m_state[m_lane] = x;
+    m_lane = (m_lane + 1) & 3;
+    return x;
+}
+
+float NoiseSource::nextUniform()
+{
+    return bitsToUniform(i_nextBits());
+}
+
+float NoiseSource::nextGaussian()
+{
+    const float sum = nextUniform() + nextUniform() + nextUniform() + nextUniform();
+    return sum * GAUSSIAN_SCALE;
+}
+
+void NoiseSource::uniform(float* output, size_t nbSamples)
+{
+    size_t i = 0;
+#ifdef ENGMSC_SIMD_SSE2
+    //Step single lanes until lane 0 is next so the vector steps line up with the scalar order
+    for(; i < nbSamples && m_lane != 0; i++)
+    {
+        output[i] = nextUniform();
+    }
+
+    __m128i state = _mm_load_si128((const __m128i*) m_state);
+    for(; i + 4 <= nbSamples; i += 4)
+    {
+        _mm_storeu_ps(output + i, bitsToUniform(xorshiftStep(state)));
+    }
+    _mm_store_si128((__m128i*) m_state, state);
+#endif
+    for(; i < nbSamples; i++)
+    {
+        output[i] = nextUniform();
+    }
+}
+
+void NoiseSource::gaussian(float* output, size_t nbSamples)
+{
+    size_t i = 0;
+#ifdef ENGMSC_SIMD_SSE2
+    if(m_lane == 0)
+    {
+        //Each lane sums its own four successive uniforms
+        __m128i state = _mm_load_si128((const __m128i*) m_state);
+        const __m128 scale = _mm_set1_ps(GAUSSIAN_SCALE);
+        for(; i + 4 <= nbSamples; i += 4)
+        {
+            __m128 sum = bitsToUniform(xorshiftStep(state));
+            sum = _mm_add_ps(sum, bitsToUniform(xorshiftStep(state)));
+            sum = _mm_add_ps(sum, bitsToUniform(xorshiftStep(state)));
+            sum = _mm_add_ps(sum, bitsToUniform(xorshiftStep(state)));
+            _mm_storeu_ps(output + i, _mm_mul_ps(sum, scale));
+        }
+        _mm_store_si128((__m128i*) m_state, state);
+    }
+#endif
+    for(; i < nbSamples; i++)
+    {
+        output[i] = nextGaussian();
+    }
+}
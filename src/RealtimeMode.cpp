@@ -0,0 +1,115 @@
+#include <engmsc/RealtimeMode.hpp>
+#include <engmsc/simd/SimdSupport.hpp>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <pthread.h>
+    #include <sched.h>
+    #include <sys/mman.h>
+#endif
+
+#ifdef ENGMSC_SIMD_SSE2
+    #include <xmmintrin.h>
+#endif
+
+#include <inttypes.h>
+
+//MXCSR flush-to-zero (bit 15) and denormals-are-zero (bit 6)
+static const unsigned MXCSR_FTZ_DAZ = 0x8040;
+
+bool RealtimeMode::flushDenormals()
+{
+#ifdef ENGMSC_SIMD_SSE2
+    _mm_setcsr(_mm_getcsr() | MXCSR_FTZ_DAZ);
+    return true;
+#elif defined(__aarch64__)
+    //FPCR.FZ flushes both inputs and results on AArch64
+    uint64_t fpcr;
+    __asm__ __volatile__("mrs %0, fpcr" : "=r"(fpcr));
+    __asm__ __volatile__("msr fpcr, %0" : : "r"(fpcr | (uint64_t(1) << 24)));
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool RealtimeMode::setFifoScheduling(int priority)
+{
+#ifdef _WIN32
+    return SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL) != 0;
+#else
+    const int minPriority = sched_get_priority_min(SCHED_FIFO);
+    const int maxPriority = sched_get_priority_max(SCHED_FIFO);
+    if(priority <= 0) priority = (minPriority + maxPriority) / 2;
+    if(priority < minPriority) priority = minPriority;
+    if(priority > maxPriority) priority = maxPriority;
+
+    sched_param param = {};
+    param.sched_priority = priority;
+    return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+#endif
+}
+
+bool RealtimeMode::pinToCpu(int cpu)
+{
+    if(cpu < 0) return false;
+#ifdef _WIN32
+    if(cpu >= int(sizeof(DWORD_PTR) * 8)) return false;
+    return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) != 0;
+#elif defined(__linux__)
+    if(cpu >= CPU_SETSIZE) return false;
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(cpu, &cpuSet);
+    return pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0;
+#else
+    //macOS only takes affinity hints, which do not guarantee a core
+    return false;
+#endif
+}
+
+bool RealtimeMode::lockMemory(const void* data, size_t size)
+{
+    if(!data || size == 0) return true;
+#ifdef _WIN32
+    return VirtualLock(const_cast<void*>(data), size) != 0;
+#else
+    return mlock(data, size) == 0;
+#endif
+}
+
+void RealtimeMode::unlockMemory(const void* data, size_t size)
+{
+    if(!data || size == 0) return;
+#ifdef _WIN32
+    VirtualUnlock(const_cast<void*>(data), size);
+#else
+    munlock(data, size);
+#endif
+}
+
+RealtimeReport RealtimeMode::applyToCurrentThread(const RealtimeOptions& options, int cpu)
+{
+    RealtimeReport report;
+    if(!options.enabled) return report;
+
+    report.applied = true;
+    if(options.flushDenormals) report.denormalsFlushed = flushDenormals();
+    if(options.fifoScheduling) report.fifoScheduling = setFifoScheduling(options.fifoPriority);
+    if(cpu >= 0) report.pinned = pinToCpu(cpu);
+    return report;
+}
+
+RealtimeReport RealtimeMode::combine(const RealtimeReport& a, const RealtimeReport& b)
+{
+    RealtimeReport report;
+    report.applied = a.applied && b.applied;
+    report.denormalsFlushed = a.denormalsFlushed && b.denormalsFlushed;
+    report.fifoScheduling = a.fifoScheduling && b.fifoScheduling;
+    report.pinned = a.pinned && b.pinned;
+    report.memoryLocked = a.memoryLocked && b.memoryLocked;
+    return report;
+}
@@ -1,6 +1,11 @@
 #include <engmsc/SoundEvent.hpp>
 
-SoundEvent::SoundEvent(IAudioProducer* producer, float volume, float pitch) :
+SoundEvent::SoundEvent(IAudioProducer* producer, float volume, float pitch, int priority) :
     audioProducer(producer),
     volume(volume),
-    pitch(pitch) {}
\ No newline at end of file
+    pitch(pitch),
+    priority(priority) {}
+
+ScheduledEvent::ScheduledEvent(const SoundEvent& event, double seconds) :
+    event(event),
+    seconds(seconds) {}
\ No newline at end of file
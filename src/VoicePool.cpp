@@ -0,0 +1,11 @@
+#include <engmsc/VoicePool.hpp>
+
+IVoicePool::IVoicePool()
+{
+    
+}
+
+IVoicePool::~IVoicePool()
+{
+    
+}
@@ -1,15 +1,50 @@
 #include <engmsc/WindProducer.hpp>
-#include <engmsc/AudioStream.hpp>
+#include <algorithm>
+#include <math.h>
 
-size_t WindProducer::produceSamples(float* buffer, size_t bufferSize)
+static const size_t NOISE_BLOCK_SIZE = 256;
+static const size_t FILTER_ORDER = 4;
+
+//Velocity, cutoff and level are updated this often; the level ramps linearly in between.
+//The noise is filtered in double precision one control block at a time.
+static const size_t CONTROL_BLOCK_SIZE = 32;
+//Time constant of the glide towards a new velocity, in seconds
+static const double VELOCITY_SMOOTHING_TIME = 0.08;
+//Cutoff moves smaller than this fraction keep the current coefficients
+static const double CUTOFF_TOLERANCE = 0.002;
+
+static inline float produceLevel(double velocity)
 {
-    m_lowPass.setup(SAMPLE_RATE, std::max(1.0, m_windVelocity * 4.25));
+    return float(std::min(velocity / 150.0, 0.9));
+}
+
+static inline float mixLevel(double velocity)
+{
+    return float(std::min(velocity / 320.0, 0.4));
+}
 
-    for(size_t i = 0; i < bufferSize; i++)
+size_t WindProducer::produceSamples(float* buffer, size_t bufferSize)
+{
+    //The noise block is written straight into the output and filtered through a double chunk
+    m_noise.uniform(buffer, bufferSize);
+    double filtered[CONTROL_BLOCK_SIZE];
+    for(size_t block = 0; block < bufferSize; block += CONTROL_BLOCK_SIZE)
     {
-        double rnd = 2.0 * (double(rand()) / RAND_MAX) - 1.0f;
-        
-        buffer[i] = m_lowPass.filter(rnd) * std::min(m_windVelocity / 150.0, 0.9);
+        const size_t blockSize = std::min(CONTROL_BLOCK_SIZE, bufferSize - block);
+        float level = produceLevel(m_windVelocity);
+        i_updateControls(blockSize);
+        const float levelStep = (produceLevel(m_windVelocity) - level) / blockSize;
+
+        for(size_t i = 0; i < blockSize; i++)
+        {
+            filtered[i] = buffer[block + i];
+        }
+        m_lowPass.process(filtered, blockSize);
+        for(size_t i = 0; i < blockSize; i++)
+        {
+            level += levelStep;
+            buffer[block + i] = float(filtered[i]) * level;
+        }
     }
 
     return bufferSize;
@@ -17,13 +52,30 @@ size_t WindProducer::produceSamples(float* buffer, size_t bufferSize)
 
 size_t WindProducer::addOntoSamples(float* buffer, size_t bufferSize, float gain)
 {
-    m_lowPass.setup(SAMPLE_RATE, std::max(1.0, m_windVelocity * 4.25));
-
-    for(size_t i = 0; i < bufferSize; i++)
+    float noise[NOISE_BLOCK_SIZE];
+    double filtered[CONTROL_BLOCK_SIZE];
+    for(size_t block = 0; block < bufferSize; block += NOISE_BLOCK_SIZE)
     {
-        double rnd = 2.0 * (double (rand()) / RAND_MAX) - 1.0f;
-        
-        buffer[i] += m_lowPass.filter(rnd) * std::min(m_windVelocity / 320.0, 0.4);
+        const size_t blockSize = std::min(NOISE_BLOCK_SIZE, bufferSize - block);
+        m_noise.uniform(noise, blockSize);
+        for(size_t control = 0; control < blockSize; control += CONTROL_BLOCK_SIZE)
+        {
+            const size_t controlSize = std::min(CONTROL_BLOCK_SIZE, blockSize - control);
+            float level = mixLevel(m_windVelocity) * gain;
+            i_updateControls(controlSize);
+            const float levelStep = (mixLevel(m_windVelocity) * gain - level) / controlSize;
+
+            for(size_t i = 0; i < controlSize; i++)
+            {
+                filtered[i] = noise[control + i];
+            }
+            m_lowPass.process(filtered, controlSize);
+            for(size_t i = 0; i < controlSize; i++)
+            {
+                level += levelStep;
+                buffer[block + control + i] += float(filtered[i]) * level;
+            }
+        }
     }
 
     return bufferSize;
@@ -39,12 +91,40 @@ bool WindProducer::hasExpired() const
     return m_expired;
 }
 
+void WindProducer::setParameter(int parameter, float value)
+{
+    if(parameter == WIND_VELOCITY) setWindVelocity(value);
+}
+
 void WindProducer::setWindVelocity(double velocity)
 {
-    m_windVelocity = velocity;
+    m_targetVelocity.store(velocity, std::memory_order_relaxed);
+}
+
+void WindProducer::setNoiseSeed(uint32_t seed)
+{
+    m_noise.setSeed(seed);
 }
 
 void WindProducer::expire()
 {
     m_expired = true;
-}
\ No newline at end of file
+}
+
+void WindProducer::i_updateControls(size_t nbSamples)
+{
+    //One-pole glide, exact for the length of the control block
+    const double target = m_targetVelocity.load(std::memory_order_relaxed);
+    m_windVelocity = target + (m_windVelocity - target) * exp(-double(nbSamples) / (m_sampleRate * VELOCITY_SMOOTHING_TIME));
+    if(fabs(m_windVelocity - target) < 1e-3) m_windVelocity = target;
+
+    //Coefficients cost trig per section, so they are only redesigned once the cutoff has moved
+    const double cutoff = std::max(1.0, m_windVelocity * 4.25);
+    if(m_filterSampleRate != m_sampleRate || fabs(cutoff - m_cutoff) > m_cutoff * CUTOFF_TOLERANCE)
+    {
+        BiquadCoefficients sections[ButterworthDesign::MAX_ORDER];
+        m_lowPass.setup(sections, ButterworthDesign::lowPass(FILTER_ORDER, m_sampleRate, cutoff, sections));
+        m_cutoff = cutoff;
+        m_filterSampleRate = m_sampleRate;
+    }
+}
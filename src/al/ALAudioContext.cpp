@@ -1,17 +1,23 @@
 #include <engmsc/al/ALAudioContext.hpp>
+#include <engmsc/debug/Tracer.hpp>
 
 #include <iostream>
 #include <cstring>
 
-typedef std::chrono::high_resolution_clock MainClock;
+typedef std::chrono::steady_clock MainClock;
 
-static const int BUFFER_SIZE_BYTES = SAMPLES_PER_BUFFER * sizeof(int16_t);
-
-static const double BUFFER_DURATION = double(SAMPLES_PER_BUFFER) / SAMPLE_RATE;
+//Polled four times per buffer of the stream with the shortest buffers
+static MainClock::duration workerIntervalFor(const AudioStream& audioStream)
+{
+    return std::chrono::duration_cast<MainClock::duration>(
+        std::chrono::duration<double>(audioStream.getBufferDuration() / 4.0)
+    );
+}
 
-static const MainClock::duration WORKER_INTERVAL = std::chrono::duration_cast<MainClock::duration>(
-    std::chrono::duration<double>(BUFFER_DURATION / 4.0)
-);
+static ALsizei bufferSizeBytes(const AudioStream& audioStream)
+{
+    return ALsizei(audioStream.getSamplesPerBuffer() * sizeof(int16_t));
+}
 
 bool ALAudioContext::initContext(void* userData)
 {
@@ -29,6 +35,7 @@ bool ALAudioContext::initContext(void* userData)
         return false;
     }
 
+    m_workerInterval = std::chrono::milliseconds(5);
     m_workerThread = new std::thread(&ALAudioContext::i_streamWorkerThread, this);
 
     return true;
@@ -40,20 +47,23 @@ void ALAudioContext::addStream(AudioStream& audioStream)
 
     StreamChannel streamChannel;
     streamChannel.audioStream = &audioStream;
+    streamChannel.alBufferPool.resize(audioStream.getBufferPoolSize());
     alGenSources(1, &streamChannel.alSource);
-    alGenBuffers(BUFFER_POOL_SIZE, streamChannel.alBufferPool);
+    alGenBuffers(ALsizei(streamChannel.alBufferPool.size()), streamChannel.alBufferPool.data());
 
     for(ALuint buffer : streamChannel.alBufferPool)
     {
-        alBufferData(buffer, AL_FORMAT_MONO16, audioStream.getNextBuffer(), BUFFER_SIZE_BYTES, SAMPLE_RATE);
+        alBufferData(buffer, AL_FORMAT_MONO16, audioStream.getNextBuffer(), bufferSizeBytes(audioStream), ALsizei(audioStream.getSampleRate()));
     }
-    alSourceQueueBuffers(streamChannel.alSource, BUFFER_POOL_SIZE, streamChannel.alBufferPool);
+    alSourceQueueBuffers(streamChannel.alSource, ALsizei(streamChannel.alBufferPool.size()), streamChannel.alBufferPool.data());
     alSourcePlay(streamChannel.alSource);
     audioStream.resartStream();
 
     std::unique_lock<std::mutex> lock(m_streamListMutex);
     m_activeStreams.push_front(streamChannel);
-;
+    m_activeStreams.front().idleBuffers.reserve(audioStream.getBufferPoolSize());
+    m_nbStreams++;
+    m_workerInterval = std::min(m_workerInterval, workerIntervalFor(audioStream));
 }
 
 bool ALAudioContext::removeStream(AudioStream& audioStream)
@@ -69,9 +79,10 @@ bool ALAudioContext::removeStream(AudioStream& audioStream)
         if(streamChannel.audioStream == streamPtr)
         {
             alDeleteSources(1, &streamChannel.alSource);
-            alDeleteBuffers(BUFFER_POOL_SIZE, streamChannel.alBufferPool);
+            alDeleteBuffers(ALsizei(streamChannel.alBufferPool.size()), streamChannel.alBufferPool.data());
 
             successfullyRemoved = true;
+            m_nbStreams--;
             return true;
         }
         return false;
@@ -91,28 +102,73 @@ void ALAudioContext::destroyContext()
     delete m_workerThread;
 }
 
+void ALAudioContext::setRealtimeOptions(const RealtimeOptions& options)
+{
+    m_realtimeOptions = options;
+}
+
+AudioContextStats ALAudioContext::getStats() const
+{
+    AudioContextStats stats;
+    stats.nbStreams = m_nbStreams.load(std::memory_order_relaxed);
+    stats.underruns = m_nbUnderruns.load(std::memory_order_relaxed);
+    stats.nbPolls = m_pollTimes.getCount();
+    stats.pollTimeAvg = m_pollTimes.getAverage();
+    stats.pollTimeP99 = m_pollTimes.getPercentile(99.0);
+    stats.pollTimeMax = m_pollTimes.getMax();
+    return stats;
+}
+
+RealtimeReport ALAudioContext::getRealtimeReport()
+{
+    std::unique_lock<std::mutex> lock(m_workerMutex);
+    return m_realtimeReport;
+}
+
 void ALAudioContext::i_streamWorkerThread()
 {
+    Tracer::registerThread("ALAudioContext worker");
+
+    {
+        //Streams without a render thread are rendered here, so this covers their render path too
+        const RealtimeReport report = RealtimeMode::applyToCurrentThread(m_realtimeOptions, m_realtimeOptions.cpu);
+        std::unique_lock<std::mutex> lock(m_workerMutex);
+        m_realtimeReport = report;
+    }
+
     while(m_workerRunning)
     {
+        MainClock::duration workerInterval;
         {
+            ENGMSC_TRACE_SCOPE("ALAudioContext::poll");
+            const MainClock::time_point pollStart = MainClock::now();
             alcMakeContextCurrent(m_alContext);
 
             std::unique_lock<std::mutex>lock(m_streamListMutex);
+            workerInterval = m_workerInterval;
             for(StreamChannel& streamChannel : m_activeStreams)
             {
+                AudioStream& audioStream = *streamChannel.audioStream;
+
                 int buffersProcessed = 0;
                 alGetSourcei(streamChannel.alSource, AL_BUFFERS_PROCESSED, &buffersProcessed);
-
-                if(buffersProcessed <= 0) continue;
-
-                while(buffersProcessed--)
+                while(buffersProcessed-- > 0)
                 {
                     ALuint buffer;
                     alSourceUnqueueBuffers(streamChannel.alSource, 1, &buffer);
+                    streamChannel.idleBuffers.push_back(buffer);
+                }
 
-                    alBufferData(buffer, AL_FORMAT_MONO16, streamChannel.audioStream->getNextBuffer(), BUFFER_SIZE_BYTES, SAMPLE_RATE);
+                //A stream with its own render thread only hands over finished blocks. If it has
+                //none ready the buffer stays idle until the next poll, without delaying other streams.
+                while(!streamChannel.idleBuffers.empty())
+                {
+                    const int16_t* data = audioStream.tryGetNextBuffer();
+                    if(!data) break;
 
+                    ALuint buffer = streamChannel.idleBuffers.back();
+                    streamChannel.idleBuffers.pop_back();
+                    alBufferData(buffer, AL_FORMAT_MONO16, data, bufferSizeBytes(audioStream), ALsizei(audioStream.getSampleRate()));
                     alSourceQueueBuffers(streamChannel.alSource, 1, &buffer);
                 }
 
@@ -121,12 +177,14 @@ void ALAudioContext::i_streamWorkerThread()
                 if(sourceState == AL_STOPPED) 
                 {
                     alSourcePlay(streamChannel.alSource);
-                    std::cout << ++streamChannel.underruns << std::endl;
+                    m_nbUnderruns.fetch_add(1, std::memory_order_relaxed);
+                    reportUnderrun(audioStream);
                 }
             }
+            m_pollTimes.record(std::chrono::duration_cast<std::chrono::nanoseconds>(MainClock::now() - pollStart).count());
         }
 
         std::unique_lock<std::mutex> lock(m_workerMutex);
-        m_workerCV.wait_for(lock, WORKER_INTERVAL);
+        m_workerCV.wait_for(lock, workerInterval);
     }
 }
\ No newline at end of file
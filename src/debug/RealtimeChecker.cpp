@@ -0,0 +1,330 @@
+#include <engmsc/debug/RealtimeChecker.hpp>
+#include <engmsc/LockFreeQueue.hpp>
+
+#ifdef ENGMSC_RT_CHECKS
+
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#elif defined(__GLIBC__) || defined(__APPLE__)
+    #include <execinfo.h>
+    #define ENGMSC_RT_EXECINFO
+#endif
+
+//Blocking calls are interposed through the dynamic linker, which only glibc is set up for here
+#if defined(__linux__) && defined(__GLIBC__)
+    #include <dlfcn.h>
+    #include <pthread.h>
+    #include <time.h>
+    #include <unistd.h>
+    #define ENGMSC_RT_INTERPOSE
+#endif
+
+static thread_local int t_scopeDepth = 0;
+static thread_local int t_allowDepth = 0;
+static thread_local bool t_recording = false;
+static thread_local const char* t_scopeName = "";
+
+static MPSCQueue<RealtimeChecker::Violation> s_violations(RealtimeChecker::VIOLATION_CAPACITY);
+static std::atomic<size_t> s_nbViolations{0};
+static std::atomic<size_t> s_nbDroppedViolations{0};
+
+static int captureStack(void** frames, int maxFrames)
+{
+#ifdef _WIN32
+    return int(CaptureStackBackTrace(2, DWORD(maxFrames), frames, nullptr));
+#elif defined(ENGMSC_RT_EXECINFO)
+    return backtrace(frames, maxFrames);
+#else
+    return 0;
+#endif
+}
+
+//The first backtrace() loads the unwinder, which allocates; do that before any scope is entered
+static const int s_stackPrimed = []()
+{
+    void* frame[1];
+    return captureStack(frame, 1);
+}();
+
+RealtimeChecker::Scope::Scope(const char* name) :
+    m_previousName(t_scopeName)
+{
+    t_scopeName = name;
+    t_scopeDepth++;
+}
+
+RealtimeChecker::Scope::~Scope()
+{
+    t_scopeDepth--;
+    t_scopeName = m_previousName;
+}
+
+RealtimeChecker::Allow::Allow()
+{
+    t_allowDepth++;
+}
+
+RealtimeChecker::Allow::~Allow()
+{
+    t_allowDepth--;
+}
+
+bool RealtimeChecker::isEnabled()
+{
+    return true;
+}
+
+bool RealtimeChecker::isInScope()
+{
+    return t_scopeDepth > 0 && t_allowDepth == 0;
+}
+
+bool RealtimeChecker::popViolation(Violation& violation)
+{
+    return s_violations.tryPop(violation);
+}
+
+size_t RealtimeChecker::getNbViolations()
+{
+    return s_nbViolations.load(std::memory_order_relaxed);
+}
+
+size_t RealtimeChecker::getNbDroppedViolations()
+{
+    return s_nbDroppedViolations.load(std::memory_order_relaxed);
+}
+
+void RealtimeChecker::check(ViolationType type, const char* call)
+{
+    if(t_scopeDepth == 0 || t_allowDepth > 0 || t_recording) return;
+
+    //Anything the recording itself does is not reported again
+    t_recording = true;
+    s_nbViolations.fetch_add(1, std::memory_order_relaxed);
+
+    Violation violation;
+    violation.type = type;
+    violation.call = call;
+    violation.scope = t_scopeName;
+    violation.nbFrames = captureStack(violation.frames, MAX_FRAMES);
+    if(!s_violations.tryPush(violation))
+    {
+        s_nbDroppedViolations.fetch_add(1, std::memory_order_relaxed);
+    }
+    t_recording = false;
+}
+
+void RealtimeChecker::printViolations(FILE* file)
+{
+    Violation violation;
+    while(popViolation(violation))
+    {
+        fprintf(file, "[RealtimeChecker : Violation]: %s (%s) in %s\n", getTypeName(violation.type), violation.call, violation.scope);
+#ifdef ENGMSC_RT_EXECINFO
+        fflush(file);
+        backtrace_symbols_fd(violation.frames, violation.nbFrames, fileno(file));
+#else
+        for(int i = 0; i < violation.nbFrames; i++)
+        {
+            fprintf(file, "    %p\n", violation.frames[i]);
+        }
+#endif
+    }
+
+    //Only new drops are reported so this can be polled every frame
+    static size_t nbDroppedReported = 0;
+    const size_t nbDropped = getNbDroppedViolations();
+    if(nbDropped != nbDroppedReported)
+    {
+        fprintf(file, "[RealtimeChecker : Warning]: %zu violations were not recorded\n", nbDropped - nbDroppedReported);
+        nbDroppedReported = nbDropped;
+    }
+    fflush(file);
+}
+
+void* operator new(size_t size)
+{
+    RealtimeChecker::check(RealtimeChecker::ALLOCATION, "operator new");
+    void* data = malloc(size ? size : 1);
+    if(!data) throw std::bad_alloc();
+    return data;
+}
+
+void* operator new[](size_t size)
+{
+    RealtimeChecker::check(RealtimeChecker::ALLOCATION, "operator new[]");
+    void* data = malloc(size ? size : 1);
+    if(!data) throw std::bad_alloc();
+    return data;
+}
+
+void operator delete(void* data) noexcept
+{
+    if(data) RealtimeChecker::check(RealtimeChecker::DEALLOCATION, "operator delete");
+    free(data);
+}
+
+void operator delete[](void* data) noexcept
+{
+    if(data) RealtimeChecker::check(RealtimeChecker::DEALLOCATION, "operator delete[]");
+    free(data);
+}
+
+void operator delete(void* data, size_t) noexcept
+{
+    operator delete(data);
+}
+
+void operator delete[](void* data, size_t) noexcept
+{
+    operator delete[](data);
+}
+
+#ifdef ENGMSC_RT_INTERPOSE
+
+//Resolved on first use without a static guard, which would itself lock
+#define ENGMSC_RT_NEXT(function) \
+    static std::atomic<void*> next{nullptr}; \
+    void* nextSymbol = next.load(std::memory_order_relaxed); \
+    if(!nextSymbol) \
+    { \
+        nextSymbol = dlsym(RTLD_NEXT, #function); \
+        next.store(nextSymbol, std::memory_order_relaxed); \
+    } \
+    decltype(&function) nextFunction = (decltype(&function)) nextSymbol;
+
+extern "C"
+{
+    int pthread_mutex_lock(pthread_mutex_t* mutex) noexcept
+    {
+        ENGMSC_RT_NEXT(pthread_mutex_lock);
+        RealtimeChecker::check(RealtimeChecker::MUTEX_LOCK, "pthread_mutex_lock");
+        return nextFunction(mutex);
+    }
+
+    int pthread_cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex)
+    {
+        ENGMSC_RT_NEXT(pthread_cond_wait);
+        RealtimeChecker::check(RealtimeChecker::BLOCKING_CALL, "pthread_cond_wait");
+        return nextFunction(cond, mutex);
+    }
+
+    int pthread_cond_timedwait(pthread_cond_t* cond, pthread_mutex_t* mutex, const struct timespec* time)
+    {
+        ENGMSC_RT_NEXT(pthread_cond_timedwait);
+        RealtimeChecker::check(RealtimeChecker::BLOCKING_CALL, "pthread_cond_timedwait");
+        return nextFunction(cond, mutex, time);
+    }
+
+#if __GLIBC__ > 2 || __GLIBC_MINOR__ >= 30
+    //std::condition_variable waits on steady_clock go through this one
+    int pthread_cond_clockwait(pthread_cond_t* cond, pthread_mutex_t* mutex, clockid_t clock, const struct timespec* time)
+    {
+        ENGMSC_RT_NEXT(pthread_cond_clockwait);
+        RealtimeChecker::check(RealtimeChecker::BLOCKING_CALL, "pthread_cond_clockwait");
+        return nextFunction(cond, mutex, clock, time);
+    }
+#endif
+
+    int nanosleep(const struct timespec* duration, struct timespec* remaining)
+    {
+        ENGMSC_RT_NEXT(nanosleep);
+        RealtimeChecker::check(RealtimeChecker::BLOCKING_CALL, "nanosleep");
+        return nextFunction(duration, remaining);
+    }
+
+    int clock_nanosleep(clockid_t clock, int flags, const struct timespec* duration, struct timespec* remaining)
+    {
+        ENGMSC_RT_NEXT(clock_nanosleep);
+        RealtimeChecker::check(RealtimeChecker::BLOCKING_CALL, "clock_nanosleep");
+        return nextFunction(clock, flags, duration, remaining);
+    }
+
+    int usleep(useconds_t duration)
+    {
+        ENGMSC_RT_NEXT(usleep);
+        RealtimeChecker::check(RealtimeChecker::BLOCKING_CALL, "usleep");
+        return nextFunction(duration);
+    }
+
+    ssize_t read(int fd, void* data, size_t size)
+    {
+        ENGMSC_RT_NEXT(read);
+        RealtimeChecker::check(RealtimeChecker::BLOCKING_CALL, "read");
+        return nextFunction(fd, data, size);
+    }
+
+    ssize_t write(int fd, const void* data, size_t size)
+    {
+        ENGMSC_RT_NEXT(write);
+        RealtimeChecker::check(RealtimeChecker::BLOCKING_CALL, "write");
+        return nextFunction(fd, data, size);
+    }
+
+    //stdio writes inside libc skip the write() above, but std::cout reaches them through here
+    size_t fwrite(const void* data, size_t size, size_t count, FILE* file)
+    {
+        ENGMSC_RT_NEXT(fwrite);
+        RealtimeChecker::check(RealtimeChecker::BLOCKING_CALL, "fwrite");
+        return nextFunction(data, size, count, file);
+    }
+}
+
+#endif
+
+#else
+
+bool RealtimeChecker::isEnabled()
+{
+    return false;
+}
+
+bool RealtimeChecker::isInScope()
+{
+    return false;
+}
+
+bool RealtimeChecker::popViolation(Violation&)
+{
+    return false;
+}
+
+size_t RealtimeChecker::getNbViolations()
+{
+    return 0;
+}
+
+size_t RealtimeChecker::getNbDroppedViolations()
+{
+    return 0;
+}
+
+void RealtimeChecker::check(ViolationType, const char*)
+{
+
+}
+
+void RealtimeChecker::printViolations(FILE*)
+{
+
+}
+
+#endif
+
+const char* RealtimeChecker::getTypeName(ViolationType type)
+{
+    switch(type)
+    {
+    case ALLOCATION:    return "allocation";
+    case DEALLOCATION:  return "deallocation";
+    case MUTEX_LOCK:    return "mutex lock";
+    case BLOCKING_CALL: return "blocking call";
+    }
+    return "unknown";
+}
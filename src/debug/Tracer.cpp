@@ -0,0 +1,179 @@
+#include <engmsc/debug/Tracer.hpp>
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+typedef std::chrono::steady_clock MainClock;
+
+namespace
+{
+    struct TraceEvent
+    {
+        std::atomic<const char*> name{nullptr};
+        std::atomic<int64_t> start{0};
+        std::atomic<int64_t> end{0};
+    };
+
+    //Written only by its thread. The reader copies events out and then re-reads the write
+    //position to discard any slot that was overwritten while it was copying.
+    struct ThreadTrace
+    {
+        ThreadTrace(const char* p_name, size_t p_id) :
+            name(p_name),
+            id(p_id),
+            events(new TraceEvent[Tracer::EVENTS_PER_THREAD]) {}
+
+        const char* const name;
+        const size_t id;
+        std::unique_ptr<TraceEvent[]> events;
+        std::atomic<uint64_t> written{0};
+        //Guarded by s_threadsMutex
+        bool inUse = true;
+    };
+
+    //Hands the ring back when its thread exits
+    struct ThreadRelease
+    {
+        ThreadTrace* trace = nullptr;
+        ~ThreadRelease();
+    };
+}
+
+static const MainClock::time_point s_epoch = MainClock::now();
+static std::atomic<bool> s_enabled{false};
+
+//Rings outlive their threads so a dump still shows threads that already exited. A thread
+//registering under the name of one that exited takes over its ring and its row.
+static std::mutex s_threadsMutex;
+static std::vector<std::unique_ptr<ThreadTrace>> s_threads;
+
+//Kept apart from the release guard so scopes read a plain pointer
+static thread_local ThreadTrace* t_trace = nullptr;
+static thread_local ThreadRelease t_release;
+
+ThreadRelease::~ThreadRelease()
+{
+    if(!trace) return;
+
+    std::unique_lock<std::mutex> lock(s_threadsMutex);
+    trace->inUse = false;
+    t_trace = nullptr;
+}
+
+Tracer::Scope::Scope(const char* name) :
+    m_name(name),
+    m_start(t_trace && s_enabled.load(std::memory_order_relaxed) ? i_now() : -1) {}
+
+Tracer::Scope::~Scope()
+{
+    if(m_start >= 0) i_record(m_name, m_start, i_now());
+}
+
+void Tracer::registerThread(const char* name)
+{
+    if(t_trace) return;
+
+    std::unique_lock<std::mutex> lock(s_threadsMutex);
+    for(const std::unique_ptr<ThreadTrace>& thread : s_threads)
+    {
+        if(!thread->inUse && strcmp(thread->name, name) == 0)
+        {
+            t_trace = thread.get();
+            break;
+        }
+    }
+    if(!t_trace)
+    {
+        s_threads.emplace_back(new ThreadTrace(name, s_threads.size() + 1));
+        t_trace = s_threads.back().get();
+    }
+    t_trace->inUse = true;
+    t_release.trace = t_trace;
+}
+
+void Tracer::setEnabled(bool enabled)
+{
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool Tracer::isEnabled()
+{
+    return s_enabled.load(std::memory_order_relaxed);
+}
+
+void Tracer::writeChromeTrace(std::ostream& stream)
+{
+    std::unique_lock<std::mutex> lock(s_threadsMutex);
+
+    //Timestamps are in microseconds with nanosecond decimals
+    stream << std::fixed << std::setprecision(3);
+    stream << "{\"traceEvents\":[\n";
+    bool first = true;
+    std::vector<std::pair<const char*, std::pair<int64_t, int64_t>>> events;
+    events.reserve(EVENTS_PER_THREAD);
+
+    for(const std::unique_ptr<ThreadTrace>& thread : s_threads)
+    {
+        stream << (first ? "" : ",\n");
+        stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread->id << ",\"args\":{\"name\":\"" << thread->name << "\"}}";
+        first = false;
+
+        const uint64_t written = thread->written.load(std::memory_order_acquire);
+        const uint64_t begin = written > EVENTS_PER_THREAD ? written - EVENTS_PER_THREAD : 0;
+
+        events.clear();
+        for(uint64_t i = begin; i < written; i++)
+        {
+            const TraceEvent& event = thread->events[i % EVENTS_PER_THREAD];
+            events.push_back({event.name.load(std::memory_order_relaxed), {event.start.load(std::memory_order_relaxed), event.end.load(std::memory_order_relaxed)}});
+        }
+
+        //Slots the writer lapped while they were being copied hold newer, unrelated events,
+        //and the one it may be writing right now could be torn
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t writtenAfter = thread->written.load(std::memory_order_acquire);
+        const uint64_t firstValid = writtenAfter + 1 > EVENTS_PER_THREAD ? writtenAfter + 1 - EVENTS_PER_THREAD : 0;
+
+        for(size_t i = 0; i < events.size(); i++)
+        {
+            if(begin + i < firstValid || !events[i].first) continue;
+
+            const int64_t start = events[i].second.first;
+            const int64_t end = events[i].second.second;
+            stream << ",\n{\"name\":\"" << events[i].first << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << thread->id
+                   << ",\"ts\":" << double(start) / 1000.0 << ",\"dur\":" << double(end - start) / 1000.0 << "}";
+        }
+    }
+    stream << "\n]}\n";
+}
+
+bool Tracer::writeChromeTrace(const char* path)
+{
+    std::ofstream file(path);
+    if(!file) return false;
+
+    writeChromeTrace(file);
+    return bool(file);
+}
+
+int64_t Tracer::i_now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(MainClock::now() - s_epoch).count();
+}
+
+void Tracer::i_record(const char* name, int64_t start, int64_t end)
+{
+    ThreadTrace& trace = *t_trace;
+    const uint64_t position = trace.written.load(std::memory_order_relaxed);
+
+    TraceEvent& event = trace.events[position % EVENTS_PER_THREAD];
+    event.name.store(name, std::memory_order_relaxed);
+    event.start.store(start, std::memory_order_relaxed);
+    event.end.store(end, std::memory_order_relaxed);
+    trace.written.store(position + 1, std::memory_order_release);
+}
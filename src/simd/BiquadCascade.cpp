@@ -0,0 +1,129 @@
+#include <engmsc/simd/BiquadCascade.hpp>
+#include <engmsc/simd/SimdSupport.hpp>
+#include "BiquadSectionLoop.hpp"
+
+#ifdef ENGMSC_SIMD_SSE2
+    #include <emmintrin.h>
+#endif
+
+namespace
+{
+    template<typename T>
+    struct ScalarOps
+    {
+        typedef T Scalar;
+        typedef T Vector;
+        static const size_t WIDTH = 1;
+
+        static T load(const T* p) { return *p; }
+        static void store(T* p, T v) { *p = v; }
+        static T add(T a, T b) { return a + b; }
+        static T sub(T a, T b) { return a - b; }
+        static T mul(T a, T b) { return a * b; }
+    };
+
+#ifdef ENGMSC_SIMD_SSE2
+    struct SSE2FloatOps
+    {
+        typedef float Scalar;
+        typedef __m128 Vector;
+        static const size_t WIDTH = 4;
+
+        static __m128 load(const float* p) { return _mm_loadu_ps(p); }
+        static void store(float* p, __m128 v) { _mm_storeu_ps(p, v); }
+        static __m128 add(__m128 a, __m128 b) { return _mm_add_ps(a, b); }
+        static __m128 sub(__m128 a, __m128 b) { return _mm_sub_ps(a, b); }
+        static __m128 mul(__m128 a, __m128 b) { return _mm_mul_ps(a, b); }
+    };
+
+    struct SSE2DoubleOps
+    {
+        typedef double Scalar;
+        typedef __m128d Vector;
+        static const size_t WIDTH = 2;
+
+        static __m128d load(const double* p) { return _mm_loadu_pd(p); }
+        static void store(double* p, __m128d v) { _mm_storeu_pd(p, v); }
+        static __m128d add(__m128d a, __m128d b) { return _mm_add_pd(a, b); }
+        static __m128d sub(__m128d a, __m128d b) { return _mm_sub_pd(a, b); }
+        static __m128d mul(__m128d a, __m128d b) { return _mm_mul_pd(a, b); }
+    };
+#endif
+}
+
+void BiquadKernel::process(const float* coefficients, float* state, float* samples, size_t nbFrames, size_t nbLanes, size_t nbSections)
+{
+    i_getDispatch().floatKernel(coefficients, state, samples, nbFrames, nbLanes, nbSections, 0);
+}
+
+void BiquadKernel::process(const double* coefficients, double* state, double* samples, size_t nbFrames, size_t nbLanes, size_t nbSections)
+{
+    i_getDispatch().doubleKernel(coefficients, state, samples, nbFrames, nbLanes, nbSections, 0);
+}
+
+const char* BiquadKernel::getKernelName()
+{
+    return i_getDispatch().name;
+}
+
+const BiquadKernel::Dispatch& BiquadKernel::i_getDispatch()
+{
+    static const Dispatch dispatch = []() -> Dispatch
+    {
+    #ifdef ENGMSC_SIMD_AVX2
+        if(SimdSupport::hasAVX2()) return { &BiquadKernel::processAVX2, &BiquadKernel::processAVX2, "avx2" };
+    #endif
+    #ifdef ENGMSC_SIMD_SSE2
+        return { &BiquadKernel::processSSE2, &BiquadKernel::processSSE2, "sse2" };
+    #else
+        return { &BiquadKernel::processScalar, &BiquadKernel::processScalar, "scalar" };
+    #endif
+    }();
+    return dispatch;
+}
+
+void BiquadKernel::processScalar(const float* coefficients, float* state, float* samples, size_t nbFrames, size_t nbLanes, size_t nbSections, size_t firstLane)
+{
+    processBiquadLanes<ScalarOps<float>>(coefficients, state, samples, nbFrames, nbLanes, nbSections, firstLane);
+}
+
+void BiquadKernel::processScalar(const double* coefficients, double* state, double* samples, size_t nbFrames, size_t nbLanes, size_t nbSections, size_t firstLane)
+{
+    processBiquadLanes<ScalarOps<double>>(coefficients, state, samples, nbFrames, nbLanes, nbSections, firstLane);
+}
+
+#ifdef ENGMSC_SIMD_SSE2
+void BiquadKernel::processSSE2(const float* coefficients, float* state, float* samples, size_t nbFrames, size_t nbLanes, size_t nbSections, size_t firstLane)
+{
+    const size_t lane = processBiquadLanes<SSE2FloatOps>(coefficients, state, samples, nbFrames, nbLanes, nbSections, firstLane);
+    processScalar(coefficients, state, samples, nbFrames, nbLanes, nbSections, lane);
+}
+
+void BiquadKernel::processSSE2(const double* coefficients, double* state, double* samples, size_t nbFrames, size_t nbLanes, size_t nbSections, size_t firstLane)
+{
+    const size_t lane = processBiquadLanes<SSE2DoubleOps>(coefficients, state, samples, nbFrames, nbLanes, nbSections, firstLane);
+    processScalar(coefficients, state, samples, nbFrames, nbLanes, nbSections, lane);
+}
+#else
+void BiquadKernel::processSSE2(const float* coefficients, float* state, float* samples, size_t nbFrames, size_t nbLanes, size_t nbSections, size_t firstLane)
+{
+    processScalar(coefficients, state, samples, nbFrames, nbLanes, nbSections, firstLane);
+}
+
+void BiquadKernel::processSSE2(const double* coefficients, double* state, double* samples, size_t nbFrames, size_t nbLanes, size_t nbSections, size_t firstLane)
+{
+    processScalar(coefficients, state, samples, nbFrames, nbLanes, nbSections, firstLane);
+}
+#endif
+
+#ifndef ENGMSC_SIMD_AVX2
+void BiquadKernel::processAVX2(const float* coefficients, float* state, float* samples, size_t nbFrames, size_t nbLanes, size_t nbSections, size_t firstLane)
+{
+    processSSE2(coefficients, state, samples, nbFrames, nbLanes, nbSections, firstLane);
+}
+
+void BiquadKernel::processAVX2(const double* coefficients, double* state, double* samples, size_t nbFrames, size_t nbLanes, size_t nbSections, size_t firstLane)
+{
+    processSSE2(coefficients, state, samples, nbFrames, nbLanes, nbSections, firstLane);
+}
+#endif
@@ -0,0 +1,47 @@
+#include <engmsc/simd/BiquadCascade.hpp>
+//Built with AVX2 code generation enabled; only reached after a runtime CPU check
+#ifdef ENGMSC_SIMD_AVX2
+#include "BiquadSectionLoop.hpp"
+#include <immintrin.h>
+
+namespace
+{
+    struct AVX2FloatOps
+    {
+        typedef float Scalar;
+        typedef __m256 Vector;
+        static const size_t WIDTH = 8;
+
+        static __m256 load(const float* p) { return _mm256_loadu_ps(p); }
+        static void store(float* p, __m256 v) { _mm256_storeu_ps(p, v); }
+        static __m256 add(__m256 a, __m256 b) { return _mm256_add_ps(a, b); }
+        static __m256 sub(__m256 a, __m256 b) { return _mm256_sub_ps(a, b); }
+        static __m256 mul(__m256 a, __m256 b) { return _mm256_mul_ps(a, b); }
+    };
+
+    struct AVX2DoubleOps
+    {
+        typedef double Scalar;
+        typedef __m256d Vector;
+        static const size_t WIDTH = 4;
+
+        static __m256d load(const double* p) { return _mm256_loadu_pd(p); }
+        static void store(double* p, __m256d v) { _mm256_storeu_pd(p, v); }
+        static __m256d add(__m256d a, __m256d b) { return _mm256_add_pd(a, b); }
+        static __m256d sub(__m256d a, __m256d b) { return _mm256_sub_pd(a, b); }
+        static __m256d mul(__m256d a, __m256d b) { return _mm256_mul_pd(a, b); }
+    };
+}
+
+void BiquadKernel::processAVX2(const float* coefficients, float* state, float* samples, size_t nbFrames, size_t nbLanes, size_t nbSections, size_t firstLane)
+{
+    const size_t lane = processBiquadLanes<AVX2FloatOps>(coefficients, state, samples, nbFrames, nbLanes, nbSections, firstLane);
+    processSSE2(coefficients, state, samples, nbFrames, nbLanes, nbSections, lane);
+}
+
+void BiquadKernel::processAVX2(const double* coefficients, double* state, double* samples, size_t nbFrames, size_t nbLanes, size_t nbSections, size_t firstLane)
+{
+    const size_t lane = processBiquadLanes<AVX2DoubleOps>(coefficients, state, samples, nbFrames, nbLanes, nbSections, firstLane);
+    processSSE2(coefficients, state, samples, nbFrames, nbLanes, nbSections, lane);
+}
+#endif
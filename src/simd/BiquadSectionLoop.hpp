@@ -0,0 +1,84 @@
+#pragma once
+
+#ifndef BIQUAD_SECTION_LOOP_HPP
+#define BIQUAD_SECTION_LOOP_HPP
+
+#include <stddef.h>
+
+//Kernel body shared by every BiquadKernel instruction set. Ops wraps one vector type: its
+//Scalar, Vector, WIDTH and load, store, add, sub and mul. Filters groups of WIDTH lanes from
+//firstLane on and returns the first lane it left for a narrower kernel.
+template<typename Ops>
+static size_t processBiquadLanes(const typename Ops::Scalar* coefficients, typename Ops::Scalar* state, typename Ops::Scalar* samples,
+                                 size_t nbFrames, size_t nbLanes, size_t nbSections, size_t firstLane)
+{
+    typedef typename Ops::Vector Vector;
+    typedef typename Ops::Scalar Scalar;
+
+    size_t lane = firstLane;
+    for(; lane + Ops::WIDTH <= nbLanes; lane += Ops::WIDTH)
+    {
+        //Sections go two at a time: each recurrence is a serial chain, and two independent
+        //ones in the same loop keep the pipeline busy
+        size_t section = 0;
+        for(; section + 2 <= nbSections; section += 2)
+        {
+            const Scalar* c = coefficients + 5 * nbLanes * section + lane;
+            const Scalar* d = c + 5 * nbLanes;
+            Scalar* s = state + 2 * nbLanes * section + lane;
+            Scalar* t = s + 2 * nbLanes;
+
+            const Vector b0 = Ops::load(c), b1 = Ops::load(c + nbLanes), b2 = Ops::load(c + 2 * nbLanes);
+            const Vector a1 = Ops::load(c + 3 * nbLanes), a2 = Ops::load(c + 4 * nbLanes);
+            const Vector e0 = Ops::load(d), e1 = Ops::load(d + nbLanes), e2 = Ops::load(d + 2 * nbLanes);
+            const Vector f1 = Ops::load(d + 3 * nbLanes), f2 = Ops::load(d + 4 * nbLanes);
+            Vector s1 = Ops::load(s), s2 = Ops::load(s + nbLanes);
+            Vector t1 = Ops::load(t), t2 = Ops::load(t + nbLanes);
+
+            Scalar* sample = samples + lane;
+            for(size_t frame = 0; frame < nbFrames; frame++, sample += nbLanes)
+            {
+                const Vector x = Ops::load(sample);
+                const Vector y = Ops::add(Ops::mul(b0, x), s1);
+                s1 = Ops::sub(Ops::add(Ops::mul(b1, x), s2), Ops::mul(a1, y));
+                s2 = Ops::sub(Ops::mul(b2, x), Ops::mul(a2, y));
+
+                const Vector z = Ops::add(Ops::mul(e0, y), t1);
+                t1 = Ops::sub(Ops::add(Ops::mul(e1, y), t2), Ops::mul(f1, z));
+                t2 = Ops::sub(Ops::mul(e2, y), Ops::mul(f2, z));
+                Ops::store(sample, z);
+            }
+
+            Ops::store(s, s1);
+            Ops::store(s + nbLanes, s2);
+            Ops::store(t, t1);
+            Ops::store(t + nbLanes, t2);
+        }
+
+        if(section < nbSections)
+        {
+            const Scalar* c = coefficients + 5 * nbLanes * section + lane;
+            Scalar* s = state + 2 * nbLanes * section + lane;
+
+            const Vector b0 = Ops::load(c), b1 = Ops::load(c + nbLanes), b2 = Ops::load(c + 2 * nbLanes);
+            const Vector a1 = Ops::load(c + 3 * nbLanes), a2 = Ops::load(c + 4 * nbLanes);
+            Vector s1 = Ops::load(s), s2 = Ops::load(s + nbLanes);
+
+            Scalar* sample = samples + lane;
+            for(size_t frame = 0; frame < nbFrames; frame++, sample += nbLanes)
+            {
+                const Vector x = Ops::load(sample);
+                const Vector y = Ops::add(Ops::mul(b0, x), s1);
+                s1 = Ops::sub(Ops::add(Ops::mul(b1, x), s2), Ops::mul(a1, y));
+                s2 = Ops::sub(Ops::mul(b2, x), Ops::mul(a2, y));
+                Ops::store(sample, y);
+            }
+
+            Ops::store(s, s1);
+            Ops::store(s + nbLanes, s2);
+        }
+    }
+    return lane;
+}
+
+#endif
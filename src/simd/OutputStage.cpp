@@ -0,0 +1,88 @@
+#include <engmsc/simd/OutputStage.hpp>
+#include <engmsc/simd/SimdSupport.hpp>
+
+#include <algorithm>
+#include <math.h>
+
+#ifdef ENGMSC_SIMD_SSE2
+    #include <emmintrin.h>
+#endif
+
+const float OutputStage::SOFT_CLIP_GAIN = 6.0f;
+const float OutputStage::OUTPUT_SCALE = 32760.0f;
+
+void OutputStage::process(const float* input, int16_t* output, size_t nbSamples)
+{
+    i_getDispatch().kernel(input, output, nbSamples);
+}
+
+const char* OutputStage::getKernelName()
+{
+    return i_getDispatch().name;
+}
+
+const OutputStage::Dispatch& OutputStage::i_getDispatch()
+{
+    static const Dispatch dispatch = []() -> Dispatch
+    {
+    #ifdef ENGMSC_SIMD_AVX2
+        if(SimdSupport::hasAVX2()) return { &OutputStage::processAVX2, "avx2" };
+    #endif
+    #ifdef ENGMSC_SIMD_SSE2
+        return { &OutputStage::processSSE2, "sse2" };
+    #else
+        return { &OutputStage::processScalar, "scalar" };
+    #endif
+    }();
+    return dispatch;
+}
+
+void OutputStage::processScalar(const float* input, int16_t* output, size_t nbSamples)
+{
+    for(size_t i = 0; i < nbSamples; i++)
+    {
+        float sample = std::max(-1.0f, std::min(input[i], 1.0f)) * SOFT_CLIP_GAIN;
+        sample = sample / (1.0f + fabsf(sample));
+        output[i] = int16_t(sample * OUTPUT_SCALE);
+    }
+}
+
+#ifdef ENGMSC_SIMD_SSE2
+void OutputStage::processSSE2(const float* input, int16_t* output, size_t nbSamples)
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 minusOne = _mm_set1_ps(-1.0f);
+    const __m128 gain = _mm_set1_ps(SOFT_CLIP_GAIN);
+    const __m128 scale = _mm_set1_ps(OUTPUT_SCALE);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+
+    size_t i = 0;
+    for(; i + 8 <= nbSamples; i += 8)
+    {
+        __m128 a = _mm_loadu_ps(input + i);
+        __m128 b = _mm_loadu_ps(input + i + 4);
+        a = _mm_mul_ps(_mm_max_ps(minusOne, _mm_min_ps(a, one)), gain);
+        b = _mm_mul_ps(_mm_max_ps(minusOne, _mm_min_ps(b, one)), gain);
+        a = _mm_div_ps(a, _mm_add_ps(one, _mm_and_ps(a, absMask)));
+        b = _mm_div_ps(b, _mm_add_ps(one, _mm_and_ps(b, absMask)));
+
+        //Truncating conversion, then a saturating pack down to 16 bits
+        const __m128i lo = _mm_cvttps_epi32(_mm_mul_ps(a, scale));
+        const __m128i hi = _mm_cvttps_epi32(_mm_mul_ps(b, scale));
+        _mm_storeu_si128((__m128i*) (output + i), _mm_packs_epi32(lo, hi));
+    }
+    processScalar(input + i, output + i, nbSamples - i);
+}
+#else
+void OutputStage::processSSE2(const float* input, int16_t* output, size_t nbSamples)
+{
+    processScalar(input, output, nbSamples);
+}
+#endif
+
+#ifndef ENGMSC_SIMD_AVX2
+void OutputStage::processAVX2(const float* input, int16_t* output, size_t nbSamples)
+{
+    processSSE2(input, output, nbSamples);
+}
+#endif
@@ -0,0 +1,33 @@
+#include <engmsc/simd/OutputStage.hpp>
+//Built with AVX2 code generation enabled; only reached after a runtime CPU check
+#ifdef ENGMSC_SIMD_AVX2
+#include <immintrin.h>
+
+void OutputStage::processAVX2(const float* input, int16_t* output, size_t nbSamples)
+{
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 minusOne = _mm256_set1_ps(-1.0f);
+    const __m256 gain = _mm256_set1_ps(SOFT_CLIP_GAIN);
+    const __m256 scale = _mm256_set1_ps(OUTPUT_SCALE);
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+
+    size_t i = 0;
+    for(; i + 16 <= nbSamples; i += 16)
+    {
+        __m256 a = _mm256_loadu_ps(input + i);
+        __m256 b = _mm256_loadu_ps(input + i + 8);
+        a = _mm256_mul_ps(_mm256_max_ps(minusOne, _mm256_min_ps(a, one)), gain);
+        b = _mm256_mul_ps(_mm256_max_ps(minusOne, _mm256_min_ps(b, one)), gain);
+        a = _mm256_div_ps(a, _mm256_add_ps(one, _mm256_and_ps(a, absMask)));
+        b = _mm256_div_ps(b, _mm256_add_ps(one, _mm256_and_ps(b, absMask)));
+
+        const __m256i lo = _mm256_cvttps_epi32(_mm256_mul_ps(a, scale));
+        const __m256i hi = _mm256_cvttps_epi32(_mm256_mul_ps(b, scale));
+
+        //packs works per 128-bit lane, so the quadwords are put back in order afterwards
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xD8);
+        _mm256_storeu_si256((__m256i*) (output + i), packed);
+    }
+    processSSE2(input + i, output + i, nbSamples - i);
+}
+#endif
@@ -0,0 +1,40 @@
+#include <engmsc/simd/SimdSupport.hpp>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    #include <intrin.h>
+    #include <immintrin.h>
+#endif
+
+bool SimdSupport::hasSSE2()
+{
+#ifdef ENGMSC_SIMD_SSE2
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool SimdSupport::hasAVX2()
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    int info[4];
+    __cpuid(info, 0);
+    if(info[0] < 7) return false;
+
+    __cpuid(info, 1);
+    const bool osSavesYmm = (info[2] & (1 << 27)) && (_xgetbv(0) & 0x6) == 0x6;
+    const bool hasAVX = info[2] & (1 << 28);
+
+    __cpuidex(info, 7, 0);
+    return osSavesYmm && hasAVX && (info[1] & (1 << 5));
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    static const bool avx2 = []()
+    {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+    }();
+    return avx2;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,143 @@
+#include <engmsc/simd/BiquadCascade.hpp>
+#include <engmsc/NoiseSource.hpp>
+
+#include "ButterworthReference.hpp"
+#include "TestCheck.hpp"
+
+#include <algorithm>
+#include <vector>
+
+//Runs every reference filter in its own lane of one multi-lane cascade and compares each lane
+//with the reference sections applied in long double. Lane counts that are not a multiple of
+//the SIMD width exercise the narrower kernels for the leftover lanes, and uneven block lengths
+//check that state carries over between calls.
+
+static const size_t NB_FRAMES = 4096;
+static const size_t BLOCK_LENGTHS[] = {1, 7, 64, 3, 256, 100};
+static const double DOUBLE_TOLERANCE = 1e-9;
+//Float sections round their state each sample; 20 Hz cutoffs are why the master bus and the
+//wind low pass (down to 1 Hz) filter in double
+static const double FLOAT_TOLERANCE = 1e-4;
+static const double MIN_FLOAT_FREQUENCY = 100.0;
+
+static const size_t NB_REFERENCES = sizeof(BUTTERWORTH_REFERENCES) / sizeof(BUTTERWORTH_REFERENCES[0]);
+
+static size_t design(const ButterworthReference& reference, BiquadCoefficients* sections)
+{
+    switch(reference.type)
+    {
+    case ButterworthReference::LOW_PASS:
+        return ButterworthDesign::lowPass(reference.order, reference.sampleRate, reference.frequency, sections);
+    case ButterworthReference::HIGH_PASS:
+        return ButterworthDesign::highPass(reference.order, reference.sampleRate, reference.frequency, sections);
+    case ButterworthReference::BAND_PASS:
+        return ButterworthDesign::bandPass(reference.order, reference.sampleRate, reference.frequency, reference.width, sections);
+    }
+    return 0;
+}
+
+//Direct form I over each reference section, in long double. The expanded polynomial would
+//not do here: with poles near z = 1 (the wind low passes, the 20 Hz high pass) it is already
+//ill-conditioned once its coefficients are rounded to double.
+static std::vector<double> filterReference(const ButterworthReference& reference, const std::vector<double>& input)
+{
+    std::vector<long double> signal(input.begin(), input.end());
+    for(size_t section = 0; section < reference.nbSections; section++)
+    {
+        const double* c = reference.sections[section];
+        long double x1 = 0.0L, x2 = 0.0L, y1 = 0.0L, y2 = 0.0L;
+        for(long double& sample : signal)
+        {
+            const long double y = c[0] * sample + c[1] * x1 + c[2] * x2 - c[3] * y1 - c[4] * y2;
+            x2 = x1;
+            x1 = sample;
+            y2 = y1;
+            y1 = y;
+            sample = y;
+        }
+    }
+    return std::vector<double>(signal.begin(), signal.end());
+}
+
+template<typename T, size_t LANES>
+static void checkLanes(const char* test, const std::vector<size_t>& references, double tolerance)
+{
+    BiquadCascade<T, LANES> cascade;
+    NoiseSource noise(7);
+    std::vector<std::vector<double>> inputs(LANES, std::vector<double>(NB_FRAMES));
+    std::vector<T> samples(NB_FRAMES * LANES);
+    for(size_t lane = 0; lane < LANES; lane++)
+    {
+        BiquadCoefficients sections[ButterworthDesign::MAX_ORDER];
+        cascade.setup(lane, sections, design(BUTTERWORTH_REFERENCES[references[lane]], sections));
+
+        //Inputs go through T first, so both sides filter exactly the same signal
+        std::vector<float> block(NB_FRAMES);
+        noise.uniform(block.data(), NB_FRAMES);
+        for(size_t frame = 0; frame < NB_FRAMES; frame++)
+        {
+            samples[frame * LANES + lane] = T(block[frame]);
+            inputs[lane][frame] = double(samples[frame * LANES + lane]);
+        }
+    }
+
+    size_t frame = 0;
+    for(size_t block = 0; frame < NB_FRAMES; block++)
+    {
+        const size_t length = std::min(BLOCK_LENGTHS[block % (sizeof(BLOCK_LENGTHS) / sizeof(BLOCK_LENGTHS[0]))], NB_FRAMES - frame);
+        cascade.process(samples.data() + frame * LANES, length);
+        frame += length;
+    }
+
+    for(size_t lane = 0; lane < LANES; lane++)
+    {
+        const ButterworthReference& reference = BUTTERWORTH_REFERENCES[references[lane]];
+        const std::vector<double> expected = filterReference(reference, inputs[lane]);
+        //Relative to the lane's peak: a 1 Hz low pass barely moves within NB_FRAMES
+        double peak = 0.0;
+        for(double sample : expected) peak = std::max(peak, fabs(sample));
+        for(size_t frame = 0; frame < NB_FRAMES; frame++)
+        {
+            if(!TestCheck::near(test, reference.name, frame, double(samples[frame * LANES + lane]), expected[frame], tolerance * peak)) break;
+        }
+    }
+}
+
+//Fills LANES lanes with the references accepted by filter, cycling through them
+template<size_t LANES, typename F>
+static std::vector<size_t> pickReferences(F filter)
+{
+    std::vector<size_t> accepted;
+    for(size_t i = 0; i < NB_REFERENCES; i++)
+    {
+        if(filter(BUTTERWORTH_REFERENCES[i])) accepted.push_back(i);
+    }
+
+    std::vector<size_t> references(LANES);
+    for(size_t lane = 0; lane < LANES; lane++)
+    {
+        references[lane] = accepted[lane % accepted.size()];
+    }
+    return references;
+}
+
+int main()
+{
+    printf("Biquad kernel: %s\n", BiquadKernel::getKernelName());
+
+    const auto any = [](const ButterworthReference&) { return true; };
+    const auto wind = [](const ButterworthReference& reference) { return reference.type == ButterworthReference::LOW_PASS && reference.frequency < MIN_FLOAT_FREQUENCY; };
+    const auto floatSafe = [](const ButterworthReference& reference) { return reference.frequency - reference.width / 2.0 >= MIN_FLOAT_FREQUENCY; };
+
+    checkLanes<double, 1>("double x1", pickReferences<1>(any), DOUBLE_TOLERANCE);
+    checkLanes<double, 3>("double x3", pickReferences<3>(any), DOUBLE_TOLERANCE);
+    checkLanes<double, NB_REFERENCES>("double all", pickReferences<NB_REFERENCES>(any), DOUBLE_TOLERANCE);
+    checkLanes<double, 5>("double wind", pickReferences<5>(wind), DOUBLE_TOLERANCE);
+
+    checkLanes<float, 1>("float x1", pickReferences<1>(floatSafe), FLOAT_TOLERANCE);
+    checkLanes<float, 5>("float x5", pickReferences<5>(floatSafe), FLOAT_TOLERANCE);
+    checkLanes<float, 13>("float x13", pickReferences<13>(floatSafe), FLOAT_TOLERANCE);
+    checkLanes<float, 32>("float x32", pickReferences<32>(floatSafe), FLOAT_TOLERANCE);
+
+    return TestCheck::getNbFailures();
+}
@@ -0,0 +1,72 @@
+#include <engmsc/ButterworthDesign.hpp>
+
+#include "ButterworthReference.hpp"
+#include "TestCheck.hpp"
+
+#include <algorithm>
+#include <vector>
+
+//Multiplies a design's sections back into one transfer function and compares its coefficients
+//with the reference tables
+
+static const double RELATIVE_TOLERANCE = 1e-9;
+
+static void multiply(std::vector<double>& polynomial, double c0, double c1, double c2)
+{
+    std::vector<double> result(polynomial.size() + 2, 0.0);
+    for(size_t i = 0; i < polynomial.size(); i++)
+    {
+        result[i] += polynomial[i] * c0;
+        result[i + 1] += polynomial[i] * c1;
+        result[i + 2] += polynomial[i] * c2;
+    }
+    polynomial.swap(result);
+}
+
+static void checkPolynomial(const char* test, const char* what, const std::vector<double>& actual, const double* expected, size_t nbCoefficients)
+{
+    const double scale = fabs(*std::max_element(expected, expected + nbCoefficients, [](double a, double b) { return fabs(a) < fabs(b); }));
+    for(size_t i = 0; i < actual.size(); i++)
+    {
+        //An odd low or high pass ends on a first-order section, whose z^-2 terms are zero
+        const double reference = i < nbCoefficients ? expected[i] : 0.0;
+        TestCheck::near(test, what, i, actual[i], reference, scale * RELATIVE_TOLERANCE);
+    }
+}
+
+int main()
+{
+    for(const ButterworthReference& reference : BUTTERWORTH_REFERENCES)
+    {
+        BiquadCoefficients sections[ButterworthDesign::MAX_ORDER];
+        size_t nbSections = 0;
+        switch(reference.type)
+        {
+        case ButterworthReference::LOW_PASS:
+            nbSections = ButterworthDesign::lowPass(reference.order, reference.sampleRate, reference.frequency, sections);
+            TestCheck::isTrue(reference.name, "section count", nbSections == ButterworthDesign::getNbSections(reference.order));
+            break;
+        case ButterworthReference::HIGH_PASS:
+            nbSections = ButterworthDesign::highPass(reference.order, reference.sampleRate, reference.frequency, sections);
+            TestCheck::isTrue(reference.name, "section count", nbSections == ButterworthDesign::getNbSections(reference.order));
+            break;
+        case ButterworthReference::BAND_PASS:
+            nbSections = ButterworthDesign::bandPass(reference.order, reference.sampleRate, reference.frequency, reference.width, sections);
+            TestCheck::isTrue(reference.name, "section count", nbSections == ButterworthDesign::getNbBandPassSections(reference.order));
+            break;
+        }
+
+        std::vector<double> b(1, 1.0);
+        std::vector<double> a(1, 1.0);
+        for(size_t i = 0; i < nbSections; i++)
+        {
+            multiply(b, sections[i].b0, sections[i].b1, sections[i].b2);
+            multiply(a, 1.0, sections[i].a1, sections[i].a2);
+        }
+
+        TestCheck::isTrue(reference.name, "transfer function length", b.size() >= reference.nbCoefficients);
+        checkPolynomial(reference.name, "b", b, reference.b, reference.nbCoefficients);
+        checkPolynomial(reference.name, "a", a, reference.a, reference.nbCoefficients);
+    }
+    return TestCheck::getNbFailures();
+}
@@ -0,0 +1,185 @@
+#pragma once
+
+#ifndef BUTTERWORTH_REFERENCE_HPP
+#define BUTTERWORTH_REFERENCE_HPP
+
+//Generated by generate_butterworth_reference.py; do not edit
+
+#include <stddef.h>
+
+struct ButterworthReference
+{
+    enum Type
+    {
+        LOW_PASS,
+        HIGH_PASS,
+        BAND_PASS
+    };
+
+    const char* name;
+    Type type;
+    size_t order;
+    double sampleRate;
+    double frequency;
+    double width;
+    //Transfer function b[0] + b[1] z^-1 + ... over 1 + a[1] z^-1 + ..., nbCoefficients terms each
+    size_t nbCoefficients;
+    double b[33];
+    double a[33];
+    //The same filter as sections b0, b1, b2, a1, a2
+    size_t nbSections;
+    double sections[16][5];
+};
+
+static const ButterworthReference BUTTERWORTH_REFERENCES[] =
+{
+    {
+        "lowPass1_44100_1000", ButterworthReference::LOW_PASS, 1, 44100.0, 1000.0, 0.0, 2,
+        {0.066605780250182378, 0.066605780250182378},
+        {1, -0.86678843949963524},
+        1,
+        {{0.066605780250182378, 0.066605780250182378, 0, -0.86678843949963524, 0}}
+    },
+    {
+        "lowPass2_44100_500", ButterworthReference::LOW_PASS, 2, 44100.0, 500.0, 0.0, 3,
+        {0.0012074051902600642, 0.0024148103805201283, 0.0012074051902600642},
+        {1, -1.899333420104083, 0.90416304086512334},
+        1,
+        {{0.0012074051902600642, 0.0024148103805201283, 0.0012074051902600642, -1.899333420104083, 0.90416304086512334}}
+    },
+    {
+        "lowPass3_48000_2000", ButterworthReference::LOW_PASS, 3, 48000.0, 2000.0, 0.0, 4,
+        {0.0017549304462081802, 0.0052647913386245412, 0.0052647913386245412, 0.0017549304462081802},
+        {1, -2.477824034448175, 2.0833473954855073, -0.59148391746766671},
+        2,
+        {{0.0017549304462081802, 0.0035098608924163605, 0.0017549304462081802, -1.7104970464692146, 0.77083684887137682}, {1, 1, 0, -0.76732698797896037, 0}}
+    },
+    {
+        "lowPass4_48000_500", ButterworthReference::LOW_PASS, 4, 48000.0, 500.0, 0.0, 5,
+        {1.0543593706680555e-06, 4.2174374826722222e-06, 6.3261562240083332e-06, 4.2174374826722222e-06, 1.0543593706680555e-06},
+        {1, -3.8289860956650208, 5.5014295933071828, -3.5151938652911725, 0.84276723739894055},
+        2,
+        {{1.0543593706680555e-06, 2.1087187413361111e-06, 1.0543593706680555e-06, -1.9469872972295479, 0.95116489103539659}, {1, 2, 1, -1.8819987984354729, 0.88603694831664881}}
+    },
+    {
+        "lowPass4_44100_10000", ButterworthReference::LOW_PASS, 4, 44100.0, 10000.0, 0.0, 5,
+        {0.069175293817502231, 0.27670117527000893, 0.41505176290501339, 0.27670117527000893, 0.069175293817502231},
+        {1, -0.36316416689465258, 0.52774422465076487, -0.07801676394454965, 0.020241407268473035},
+        2,
+        {{0.069175293817502231, 0.13835058763500446, 0.069175293817502231, -0.21111006384167588, 0.45073668510441917}, {1, 2, 1, -0.15205410305297673, 0.044907388143443083}}
+    },
+    {
+        "lowPass5_44100_3000", ButterworthReference::LOW_PASS, 5, 44100.0, 3000.0, 0.0, 6,
+        {0.00023952761616537991, 0.0011976380808268994, 0.0023952761616537989, 0.0023952761616537989, 0.0011976380808268994, 0.00023952761616537991},
+        {1, -3.6197240577454299, 5.3844884611166037, -4.0886496570526276, 1.579037255944415, -0.24748711854566907},
+        3,
+        {{0.00023952761616537991, 0.00047905523233075981, 0.00023952761616537991, -1.6133984353001376, 0.77289690859950777}, {1, 2, 1, -1.3629781118633366, 0.4977203573163137}, {1, 1, 0, -0.64334751058195605, 0}}
+    },
+    {
+        "lowPass8_48000_4000", ButterworthReference::LOW_PASS, 8, 48000.0, 4000.0, 0.0, 9,
+        {6.8046691360833693e-06, 5.4437353088666955e-05, 0.00019053073581033433, 0.00038106147162066866, 0.00047632683952583585, 0.00038106147162066866, 0.00019053073581033433, 5.4437353088666955e-05, 6.8046691360833693e-06},
+        {1, -5.3191965258226679, 12.70140148901897, -17.70224408736356, 15.702162422825225, -9.0563613702949652, 3.3108520912222432, -0.70045253394777718, 0.065580509661370828},
+        4,
+        {{6.8046691360833693e-06, 1.3609338272166739e-05, 6.8046691360833693e-06, -1.5781134746000223, 0.82224847874419704}, {1, 2, 1, -1.3555102381375967, 0.56520840175607034}, {1, 2, 1, -1.2234288512532383, 0.41269395321082342}, {1, 2, 1, -1.1621439618318103, 0.34192825840138791}}
+    },
+    {
+        "lowPass4_44100_1", ButterworthReference::LOW_PASS, 4, 44100.0, 1.0, 0.0, 5,
+        {2.5749232597798185e-17, 1.0299693039119274e-16, 1.5449539558678912e-16, 1.0299693039119274e-16, 2.5749232597798185e-17},
+        {1, -3.9996276926430632, 5.9988831472340092, -3.9988832165312704, 0.99962776194032565},
+        2,
+        {{2.5749232597798185e-17, 5.1498465195596371e-17, 2.5749232597798185e-17, -1.9998909393471236, 0.99989095964538677}, {1, 2, 1, -1.9997367532959398, 0.99973677359263802}}
+    },
+    {
+        "lowPass4_48000_4.25", ButterworthReference::LOW_PASS, 4, 48000.0, 4.25, 0.0, 5,
+        {5.9823887319534854e-15, 2.3929554927813942e-14, 3.5894332391720913e-14, 2.3929554927813942e-14, 5.9823887319534854e-15},
+        {1, -3.9985462561257132, 5.995639824969583, -3.9956408811122333, 0.99854731226845928},
+        2,
+        {{5.9823887319534854e-15, 1.1964777463906971e-14, 5.9823887319534854e-15, -1.9995739894964475, 0.99957429892662131}, {1, 2, 1, -1.9989722666292657, 0.99897257596632405}}
+    },
+    {
+        "lowPass4_44100_10", ButterworthReference::LOW_PASS, 4, 44100.0, 10.0, 0.0, 5,
+        {2.5706146101457593e-13, 1.0282458440583037e-12, 1.5423687660874556e-12, 1.0282458440583037e-12, 2.5706146101457593e-13},
+        {1, -3.9962769265819231, 5.9888377088183766, -3.988844630339206, 0.99628384810686477},
+        2,
+        {{2.5706146101457593e-13, 5.1412292202915186e-13, 2.5706146101457593e-13, -1.9989081027667881, 0.99891013159725428}, {1, 2, 1, -1.9973688238151348, 0.99737085108328005}}
+    },
+    {
+        "lowPass4_48000_42.5", ButterworthReference::LOW_PASS, 4, 48000.0, 42.5, 0.0, 5,
+        {5.9434412262680544e-11, 2.3773764905072218e-10, 3.5660647357608326e-10, 2.3773764905072218e-10, 5.9434412262680544e-11},
+        {1, -3.9854625702636133, 5.9564932860400903, -3.9565984127145311, 0.98556769788900422},
+        2,
+        {{5.9434412262680544e-11, 1.1886882452536109e-10, 5.9434412262680544e-11, -1.9957202665126323, 0.995751150288682}, {1, 2, 1, -1.9897423037509807, 0.98977309501804189}}
+    },
+    {
+        "lowPass4_44100_85", ButterworthReference::LOW_PASS, 4, 44100.0, 85.0, 0.0, 5,
+        {1.3233360681896753e-09, 5.2933442727587012e-09, 7.9400164091380517e-09, 5.2933442727587012e-09, 1.3233360681896753e-09},
+        {1, -3.9683539684893843, 5.9055616799109689, -3.9060568433878453, 0.96884915313963882},
+        2,
+        {{1.3233360681896753e-09, 2.6466721363793506e-09, 1.3233360681896753e-09, -1.9906280627731696, 0.99077404738387842}, {1, 2, 1, -1.9777259057162144, 0.97787094413490949}}
+    },
+    {
+        "highPass1_44100_100", ButterworthReference::HIGH_PASS, 1, 44100.0, 100.0, 0.0, 2,
+        {0.99292647778469867, -0.99292647778469867},
+        {1, -0.98585295556939723},
+        1,
+        {{0.99292647778469867, -0.99292647778469867, 0, -0.98585295556939723, 0}}
+    },
+    {
+        "highPass2_48000_200", ButterworthReference::HIGH_PASS, 2, 48000.0, 200.0, 0.0, 3,
+        {0.9816582684032612, -1.9633165368065224, 0.9816582684032612},
+        {1, -1.9629800893893397, 0.96365298422370549},
+        1,
+        {{0.9816582684032612, -1.9633165368065224, 0.9816582684032612, -1.9629800893893397, 0.96365298422370549}}
+    },
+    {
+        "highPass3_44100_5000", ButterworthReference::HIGH_PASS, 3, 44100.0, 5000.0, 0.0, 4,
+        {0.48251449879434771, -1.4475434963830431, 1.4475434963830431, -0.48251449879434771},
+        {1, -1.5984510007156598, 1.0294623243839245, -0.23220266525519809},
+        2,
+        {{0.48251449879434771, -0.96502899758869543, 0.48251449879434771, -1.1407875842229454, 0.50736558109598107}, {1, -1, 0, -0.45766341649271447, 0}}
+    },
+    {
+        "highPass4_48000_20", ButterworthReference::HIGH_PASS, 4, 48000.0, 20.0, 0.0, 5,
+        {0.99658526851431095, -3.9863410740572438, 5.9795116110858659, -3.9863410740572438, 0.99658526851431095},
+        {1, -3.9931588532615718, 5.9794999507181554, -3.9795232948295109, 0.99318219741974201},
+        2,
+        {{0.99658526851431095, -1.9931705370286219, 0.99658526851431095, -1.9951674183225132, 0.99517425567298812}, {1, -2, 1, -1.9979914349390584, 0.99799828196731333}}
+    },
+    {
+        "highPass4_44100_1000", ButterworthReference::HIGH_PASS, 4, 44100.0, 1000.0, 0.0, 5,
+        {0.82999258141317112, -3.3199703256526845, 4.9799554884790265, -3.3199703256526845, 0.82999258141317112},
+        {1, -3.6278442021902721, 4.9512251332510298, -3.0119242815053822, 0.68888768566405034},
+        2,
+        {{0.82999258141317112, -1.6599851628263422, 0.82999258141317112, -1.7501415049742757, 0.76805638441596857}, {1, -2, 1, -1.8777026972159967, 0.89692332443520006}}
+    },
+    {
+        "bandPass1_44100_1000_200", ButterworthReference::BAND_PASS, 1, 44100.0, 1000.0, 200.0, 3,
+        {0.014048380811045249, 0, -0.014048380811045249},
+        {1, -1.9521210059201717, 0.9719032383779096},
+        1,
+        {{0.014048380811045249, 0, -0.014048380811045249, -1.9521210059201717, 0.9719032383779096}}
+    },
+    {
+        "bandPass2_48000_5000_2000", ButterworthReference::BAND_PASS, 2, 48000.0, 5000.0, 2000.0, 5,
+        {0.014401440346511215, 0, -0.028802880693022431, 0, 0.014401440346511215},
+        {1, -2.907118058203872, 3.761151284061663, -2.4119530978531127, 0.69059892324149674},
+        2,
+        {{0.014401440346511215, -0.028802880693022431, 0.014401440346511215, -1.5726060200639742, 0.85045444533656966}, {1, 2, 1, -1.3345120381398976, 0.8120351736984458}}
+    },
+    {
+        "bandPass3_44100_300_100", ButterworthReference::BAND_PASS, 3, 44100.0, 300.0, 100.0, 7,
+        {3.5642502562555652e-07, 0, -1.0692750768766697e-06, 0, 1.0692750768766697e-06, 0, -3.5642502562555652e-07},
+        {1, -5.9662024864072496, 14.836829415757915, -19.68516990406296, 14.696568358900858, -5.8539321314365953, 0.97190675277024585},
+        3,
+        {{3.5642502562555652e-07, -7.1285005125111304e-07, 3.5642502562555652e-07, -1.9926083355607986, 0.99392957941879878}, {1, 0, -1, -1.9895045949893384, 0.99187476540936348}, {1, 2, 1, -1.9840895558571132, 0.98585295556939723}}
+    },
+    {
+        "bandPass4_48000_2500_1000", ButterworthReference::BAND_PASS, 4, 48000.0, 2500.0, 1000.0, 9,
+        {1.5551721780891783e-05, 0, -6.2206887123567132e-05, 0, 9.3310330685350697e-05, 0, -6.2206887123567132e-05, 0, 1.5551721780891783e-05},
+        {1, -7.2672076833257533, 23.47474864140953, -43.994031699710462, 52.301333103414478, -40.384142018381112, 19.780599787287322, -5.6213125423467272, 0.7101038983415866},
+        4,
+        {{1.5551721780891783e-05, -3.1103443561783566e-05, 1.5551721780891783e-05, -1.8116191799080346, 0.89416010125867285}, {1, -2, 1, -1.891044881409224, 0.95981307858922826}, {1, 2, 1, -1.7990466808472674, 0.94273796529065401}, {1, 2, 1, -1.765496941161228, 0.87766534279249253}}
+    }
+};
+
+#endif
@@ -0,0 +1,77 @@
+#include <engmsc/simd/BiquadCascade.hpp>
+
+#include <Iir.h>
+
+#include "TestCheck.hpp"
+
+#include <vector>
+
+//The designs replaced iir1's Butterworth filters, so their impulse responses are compared with
+//iir1's directly. Built only when the iir1 target is part of the build.
+
+static const size_t NB_SAMPLES = 4096;
+static const double TOLERANCE = 1e-9;
+
+template<typename IirFilter>
+static void compare(const char* test, IirFilter& iirFilter, const BiquadCoefficients* sections, size_t nbSections)
+{
+    BiquadCascade<double> cascade;
+    cascade.setup(sections, nbSections);
+
+    std::vector<double> expected(NB_SAMPLES);
+    std::vector<double> actual(NB_SAMPLES, 0.0);
+    actual[0] = 1.0;
+    for(size_t i = 0; i < NB_SAMPLES; i++)
+    {
+        expected[i] = iirFilter.filter(i == 0 ? 1.0 : 0.0);
+    }
+    cascade.process(actual.data(), NB_SAMPLES);
+
+    for(size_t i = 0; i < NB_SAMPLES; i++)
+    {
+        if(!TestCheck::near(test, "impulse response", i, actual[i], expected[i], TOLERANCE)) break;
+    }
+}
+
+int main()
+{
+    BiquadCoefficients sections[ButterworthDesign::MAX_ORDER];
+
+    //The master bus filters
+    {
+        Iir::Butterworth::HighPass<4> filter;
+        filter.setup(48000.0, 20.0);
+        compare("highPass4 20 Hz", filter, sections, ButterworthDesign::highPass(4, 48000.0, 20.0, sections));
+    }
+    {
+        Iir::Butterworth::LowPass<4> filter;
+        filter.setup(48000.0, 500.0);
+        compare("lowPass4 500 Hz", filter, sections, ButterworthDesign::lowPass(4, 48000.0, 500.0, sections));
+    }
+
+    //Odd orders end on a first-order section
+    {
+        Iir::Butterworth::LowPass<3> filter;
+        filter.setup(44100.0, 2000.0);
+        compare("lowPass3 2 kHz", filter, sections, ButterworthDesign::lowPass(3, 44100.0, 2000.0, sections));
+    }
+    {
+        Iir::Butterworth::HighPass<5> filter;
+        filter.setup(44100.0, 1000.0);
+        compare("highPass5 1 kHz", filter, sections, ButterworthDesign::highPass(5, 44100.0, 1000.0, sections));
+    }
+
+    //Band passes of order N have 2N poles, edges at center -+ width / 2
+    {
+        Iir::Butterworth::BandPass<4> filter;
+        filter.setup(48000.0, 2500.0, 1000.0);
+        compare("bandPass4 2.5 kHz", filter, sections, ButterworthDesign::bandPass(4, 48000.0, 2500.0, 1000.0, sections));
+    }
+    {
+        Iir::Butterworth::BandPass<3> filter;
+        filter.setup(44100.0, 300.0, 100.0);
+        compare("bandPass3 300 Hz", filter, sections, ButterworthDesign::bandPass(3, 44100.0, 300.0, 100.0, sections));
+    }
+
+    return TestCheck::getNbFailures();
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#ifndef TEST_CHECK_HPP
+#define TEST_CHECK_HPP
+
+#include <stdio.h>
+#include <math.h>
+
+//Checks for the test executables: a failed check prints what differed and is counted, and a
+//test's main returns getNbFailures() so ctest sees a nonzero exit status
+class TestCheck
+{
+public:
+    static bool near(const char* test, const char* what, size_t index, double actual, double expected, double tolerance)
+    {
+        if(fabs(actual - expected) <= tolerance) return true;
+
+        if(s_nbFailures++ < MAX_REPORTED)
+        {
+            printf("FAIL %s: %s[%zu] = %.17g, expected %.17g (tolerance %.3g)\n", test, what, index, actual, expected, tolerance);
+        }
+        return false;
+    }
+
+    static bool isTrue(const char* test, const char* what, bool condition)
+    {
+        if(condition) return true;
+
+        if(s_nbFailures++ < MAX_REPORTED) printf("FAIL %s: %s\n", test, what);
+        return false;
+    }
+
+    static int getNbFailures()
+    {
+        if(s_nbFailures) printf("%d check(s) failed\n", s_nbFailures);
+        return s_nbFailures;
+    }
+private:
+    static const int MAX_REPORTED = 50;
+    static inline int s_nbFailures = 0;
+};
+
+#endif
@@ -0,0 +1,177 @@
+#!/usr/bin/env python3
+"""Writes ButterworthReference.hpp: full transfer function coefficients of digital Butterworth
+filters, designed the way scipy.signal.butter does (analog prototype zeros/poles, frequency
+transform, bilinear transform, then polynomial expansion). The same digital zeros and poles are
+also written as second-order sections, which stay usable as a filtering reference at cutoffs
+where the expanded polynomial is too ill-conditioned. Only the standard library is used, so the
+tables can be regenerated without scipy:
+
+    python3 generate_butterworth_reference.py > ButterworthReference.hpp
+"""
+
+import cmath
+import math
+
+# (name, kind, order, sample rate, frequency, width) - width is only used by band passes
+CASES = [
+    ("lowPass1_44100_1000", "low", 1, 44100, 1000.0, 0.0),
+    ("lowPass2_44100_500", "low", 2, 44100, 500.0, 0.0),
+    ("lowPass3_48000_2000", "low", 3, 48000, 2000.0, 0.0),
+    ("lowPass4_48000_500", "low", 4, 48000, 500.0, 0.0),
+    ("lowPass4_44100_10000", "low", 4, 44100, 10000.0, 0.0),
+    ("lowPass5_44100_3000", "low", 5, 44100, 3000.0, 0.0),
+    ("lowPass8_48000_4000", "low", 8, 48000, 4000.0, 0.0),
+    # The wind low pass runs from 1 Hz up
+    ("lowPass4_44100_1", "low", 4, 44100, 1.0, 0.0),
+    ("lowPass4_48000_4.25", "low", 4, 48000, 4.25, 0.0),
+    ("lowPass4_44100_10", "low", 4, 44100, 10.0, 0.0),
+    ("lowPass4_48000_42.5", "low", 4, 48000, 42.5, 0.0),
+    ("lowPass4_44100_85", "low", 4, 44100, 85.0, 0.0),
+    ("highPass1_44100_100", "high", 1, 44100, 100.0, 0.0),
+    ("highPass2_48000_200", "high", 2, 48000, 200.0, 0.0),
+    ("highPass3_44100_5000", "high", 3, 44100, 5000.0, 0.0),
+    ("highPass4_48000_20", "high", 4, 48000, 20.0, 0.0),
+    ("highPass4_44100_1000", "high", 4, 44100, 1000.0, 0.0),
+    ("bandPass1_44100_1000_200", "band", 1, 44100, 1000.0, 200.0),
+    ("bandPass2_48000_5000_2000", "band", 2, 48000, 5000.0, 2000.0),
+    ("bandPass3_44100_300_100", "band", 3, 44100, 300.0, 100.0),
+    ("bandPass4_48000_2500_1000", "band", 4, 48000, 2500.0, 1000.0),
+]
+
+
+def prototype(order):
+    poles = [-cmath.exp(1j * math.pi * m / (2 * order)) for m in range(-order + 1, order, 2)]
+    return [], poles, 1.0
+
+
+def product(values):
+    result = 1.0
+    for value in values:
+        result *= value
+    return result
+
+
+def low_to_low(zeros, poles, gain, wo):
+    degree = len(poles) - len(zeros)
+    return [wo * z for z in zeros], [wo * p for p in poles], gain * wo ** degree
+
+
+def low_to_high(zeros, poles, gain, wo):
+    degree = len(poles) - len(zeros)
+    gain *= (product(-z for z in zeros) / product(-p for p in poles)).real
+    return [wo / z for z in zeros] + [0.0] * degree, [wo / p for p in poles], gain
+
+
+def low_to_band(zeros, poles, gain, wo, bw):
+    degree = len(poles) - len(zeros)
+    zeros = [z * bw / 2 for z in zeros]
+    poles = [p * bw / 2 for p in poles]
+    band_zeros = [z + cmath.sqrt(z * z - wo * wo) for z in zeros] + [z - cmath.sqrt(z * z - wo * wo) for z in zeros]
+    band_poles = [p + cmath.sqrt(p * p - wo * wo) for p in poles] + [p - cmath.sqrt(p * p - wo * wo) for p in poles]
+    return band_zeros + [0.0] * degree, band_poles, gain * bw ** degree
+
+
+def bilinear(zeros, poles, gain, fs):
+    fs2 = 2.0 * fs
+    degree = len(poles) - len(zeros)
+    digital_zeros = [(fs2 + z) / (fs2 - z) for z in zeros] + [-1.0] * degree
+    digital_poles = [(fs2 + p) / (fs2 - p) for p in poles]
+    gain *= (product(fs2 - z for z in zeros) / product(fs2 - p for p in poles)).real
+    return digital_zeros, digital_poles, gain
+
+
+def expand(roots):
+    coefficients = [1.0 + 0j]
+    for root in roots:
+        coefficients = [a - root * b for a, b in zip(coefficients + [0j], [0j] + coefficients)]
+    return [c.real for c in coefficients]
+
+
+def design(kind, order, sample_rate, frequency, width):
+    # Normalized like scipy: frequencies over Nyquist, prewarped with fs = 2
+    fs = 2.0
+
+    def warp(f):
+        return 2.0 * fs * math.tan(math.pi * (f / (sample_rate / 2.0)) / fs)
+
+    zeros, poles, gain = prototype(order)
+    if kind == "low":
+        zeros, poles, gain = low_to_low(zeros, poles, gain, warp(frequency))
+    elif kind == "high":
+        zeros, poles, gain = low_to_high(zeros, poles, gain, warp(frequency))
+    else:
+        low, high = warp(frequency - width / 2.0), warp(frequency + width / 2.0)
+        zeros, poles, gain = low_to_band(zeros, poles, gain, math.sqrt(low * high), high - low)
+    zeros, poles, gain = bilinear(zeros, poles, gain, fs)
+    return [gain * b for b in expand(zeros)], expand(poles), sections(zeros, poles, gain)
+
+
+def sections(zeros, poles, gain):
+    """Pairs each pole with its conjugate and the zeros two by two; the gain goes on the first
+    section. A leftover real pole and zero make a first-order section."""
+    pairs = [[p, p.conjugate()] for p in poles if p.imag > 1e-12]
+    real_poles = [p for p in poles if abs(p.imag) <= 1e-12]
+    pairs += [real_poles[i:i + 2] for i in range(0, len(real_poles), 2)]
+    zeros = [complex(z) for z in zeros]
+    result = []
+    for index, pair in enumerate(pairs):
+        b = expand(zeros[2 * index:2 * index + len(pair)])
+        a = expand(pair)
+        b, a = b + [0.0] * (3 - len(b)), a + [0.0] * (3 - len(a))
+        result.append([gain * c if index == 0 else c for c in b] + a[1:])
+    return result
+
+
+def main():
+    print("#pragma once")
+    print()
+    print("#ifndef BUTTERWORTH_REFERENCE_HPP")
+    print("#define BUTTERWORTH_REFERENCE_HPP")
+    print()
+    print("//Generated by generate_butterworth_reference.py; do not edit")
+    print()
+    print("#include <stddef.h>")
+    print()
+    print("struct ButterworthReference")
+    print("{")
+    print("    enum Type")
+    print("    {")
+    print("        LOW_PASS,")
+    print("        HIGH_PASS,")
+    print("        BAND_PASS")
+    print("    };")
+    print()
+    print("    const char* name;")
+    print("    Type type;")
+    print("    size_t order;")
+    print("    double sampleRate;")
+    print("    double frequency;")
+    print("    double width;")
+    print("    //Transfer function b[0] + b[1] z^-1 + ... over 1 + a[1] z^-1 + ..., nbCoefficients terms each")
+    print("    size_t nbCoefficients;")
+    print("    double b[33];")
+    print("    double a[33];")
+    print("    //The same filter as sections b0, b1, b2, a1, a2")
+    print("    size_t nbSections;")
+    print("    double sections[16][5];")
+    print("};")
+    print()
+    print("static const ButterworthReference BUTTERWORTH_REFERENCES[] =")
+    print("{")
+    types = {"low": "LOW_PASS", "high": "HIGH_PASS", "band": "BAND_PASS"}
+    for index, (name, kind, order, sample_rate, frequency, width) in enumerate(CASES):
+        b, a, biquads = design(kind, order, sample_rate, frequency, width)
+        print("    {")
+        print("        \"%s\", ButterworthReference::%s, %d, %d.0, %r, %r, %d," % (name, types[kind], order, sample_rate, frequency, width, len(b)))
+        print("        {%s}," % ", ".join("%.17g" % c for c in b))
+        print("        {%s}," % ", ".join("%.17g" % c for c in a))
+        print("        %d," % len(biquads))
+        print("        {%s}" % ", ".join("{%s}" % ", ".join("%.17g" % c for c in biquad) for biquad in biquads))
+        print("    }%s" % ("," if index + 1 < len(CASES) else ""))
+    print("};")
+    print()
+    print("#endif")
+
+
+if __name__ == "__main__":
+    main()